@@ -0,0 +1,120 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  class Service
+  {
+  public:
+    // stands in for a call that blocks on I/O
+    int Fetch( int key )
+    {
+      std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+      return key;
+    }
+
+    int Lookup( int key )
+    {
+      return key * 2;
+    }
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN_FLAGS( Service, Fetch, Interpp::LongRunning, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Service, Lookup, int, int )
+
+//=================================================================================================
+
+namespace
+{
+  // every fourth command is a slow Fetch; the rest are Lookups
+  std::string Command( unsigned long i )
+  {
+    return ( i % 4 == 0 ? "service.Fetch( " : "service.Lookup( " ) + std::to_string( i ) + " )";
+  }
+
+  void ReportLatencies( const std::string& name, std::vector< double >& latencies )
+  {
+    std::sort( latencies.begin(), latencies.end() );
+
+    double total = 0;
+
+    for( unsigned long i = 0; i < latencies.size(); ++i )
+    {
+      total += latencies[i];
+    }
+
+    Bench::Report( name + ", mean Lookup latency", total / latencies.size() / 1000, "us" );
+    Bench::Report( name + ", max Lookup latency", latencies.back() / 1000, "us" );
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+
+void Bench::AsyncBench()
+{
+  const unsigned long commandCount = 64;
+
+  Service service;
+  Interpp::RegisterObject( service, "service" );
+
+  // all commands arrive at once; latency is measured from then until each Lookup's result is ready
+  std::vector< double > latencies;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for( unsigned long i = 0; i < commandCount; ++i )
+  {
+    std::string result = Interpp::Execute( Command( i ) );
+
+    if( i % 4 != 0 )
+    {
+      latencies.push_back( std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() );
+      sink += result.size();
+    }
+  }
+
+  ReportLatencies( "Execute", latencies );
+
+  // start the default executor's threads before timing
+  Interpp::ExecuteAsync( Command( 0 ) ).wait();
+
+  latencies.clear();
+  std::vector< std::future< std::string > > fetches;
+  start = std::chrono::steady_clock::now();
+
+  for( unsigned long i = 0; i < commandCount; ++i )
+  {
+    std::future< std::string > result = Interpp::ExecuteAsync( Command( i ) );
+
+    if( i % 4 == 0 )
+    {
+      fetches.push_back( std::move( result ) );
+    }
+    else
+    {
+      sink += result.get().size();
+      latencies.push_back( std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count() );
+    }
+  }
+
+  for( unsigned long i = 0; i < fetches.size(); ++i )
+  {
+    if( fetches[i].get() != std::to_string( i * 4 ) )
+    {
+      Fail( "ExecuteAsync returned the wrong result for Fetch " + std::to_string( i ) );
+      break;
+    }
+  }
+
+  ReportLatencies( "ExecuteAsync", latencies );
+}
+
+//=================================================================================================
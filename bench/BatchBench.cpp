@@ -0,0 +1,96 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  class Counter
+  {
+  public:
+    int Add( int value )
+    {
+      return _total += value;
+    }
+
+    int Total()
+    {
+      return _total;
+    }
+
+  private:
+    int _total = 0;
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Counter, Add, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Counter, Total, int )
+
+//=================================================================================================
+
+void Bench::BatchBench()
+{
+  const unsigned long commandCount = 10000;
+  const unsigned long rounds = 50;
+
+  Counter counters[4];
+  const char* counterNames[] = { "a", "b", "c", "d" };
+
+  for( unsigned long i = 0; i < 4; ++i )
+  {
+    Interpp::RegisterObject( counters[i], counterNames[i] );
+  }
+
+  std::vector< std::string > commands;
+  std::string commandLines;
+
+  for( unsigned long i = 0; i < commandCount; ++i )
+  {
+    std::string object = counterNames[i % 4];
+    commands.push_back( i % 8 == 7 ? object + ".Total()" : object + ".Add( " + std::to_string( i % 100 ) + " )" );
+    commandLines += commands.back() + '\n';
+  }
+
+  // both paths must produce the same results
+  Interpp::BatchResults results;
+  Interpp::ExecuteBatch( commands.data(), commandCount, results );
+
+  for( unsigned long i = 0; i < 4; ++i )
+  {
+    Interpp::RegisterObject( counters[i] = Counter(), counterNames[i] );
+  }
+
+  for( unsigned long i = 0; i < commandCount; ++i )
+  {
+    if( Interpp::Execute( commands[i] ) != results[i] )
+    {
+      Fail( "ExecuteBatch result " + std::to_string( i ) + " differs from Execute" );
+      break;
+    }
+  }
+
+  Report( "Execute loop, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    for( unsigned long i = 0; i < commandCount; ++i )
+    {
+      sink += Interpp::Execute( commands[i] ).size();
+    }
+  } ), commandCount ) );
+
+  Report( "ExecuteBatch (array), per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    Interpp::ExecuteBatch( commands.data(), commandCount, results );
+    sink += results.Text().size();
+  } ), commandCount ) );
+
+  Report( "ExecuteBatch (newline-delimited), per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    Interpp::ExecuteBatch( commandLines, results );
+    sink += results.Text().size();
+  } ), commandCount ) );
+}
+
+//=================================================================================================
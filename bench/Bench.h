@@ -0,0 +1,83 @@
+#ifndef INTERPP_BENCH_H
+#define INTERPP_BENCH_H
+
+#include <chrono>
+#include <string>
+
+//=================================================================================================
+
+namespace Bench
+{
+  // written to by benchmarks so that the compiler cannot discard the work being timed
+  extern volatile unsigned long sink;
+
+  //-------------------------------------------------------------------------------------------------
+
+  // heap allocations made so far by the calling thread (interpp_bench replaces operator new)
+  unsigned long long Allocations();
+
+  // allocations per call measured by the last NsPerOp() on this thread, reported alongside ns/op
+  extern thread_local double allocsPerOp;
+
+  //-------------------------------------------------------------------------------------------------
+
+  // calls fn( i ) for i in [0, iterations) and returns the average nanoseconds per call
+  template< class Fn >
+  double NsPerOp( unsigned long iterations, Fn fn )
+  {
+    unsigned long long allocations = Allocations();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for( unsigned long i = 0; i < iterations; ++i )
+    {
+      fn( i );
+    }
+
+    std::chrono::duration< double, std::nano > elapsed = std::chrono::steady_clock::now() - start;
+    allocsPerOp = ( double ) ( Allocations() - allocations ) / iterations;
+    return elapsed.count() / iterations;
+  }
+
+  // scales an NsPerOp() result (and its allocations) from one call to one of itemCount items it did
+  inline double PerItem( double nsPerOp, unsigned long itemCount )
+  {
+    allocsPerOp /= itemCount;
+    return nsPerOp / itemCount;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // ns/op values are reported with the allocations per op of the NsPerOp() that measured them
+  void Report( const std::string& name, double value, const char* unit = "ns/op" );
+
+  // records a failed correctness check; interpp_bench exits non-zero if any were recorded
+  void Fail( const std::string& message );
+  bool Failed();
+
+  //-------------------------------------------------------------------------------------------------
+
+  // benchmark groups, selectable by name from the command line
+  void RegistryBench();
+  void ConcurrencyBench();
+  void ConvertBench();
+  void TypedBench();
+  void BatchBench();
+  void ParallelBench();
+  void ScriptBench();
+  void AsyncBench();
+  void MemoBench();
+  void ProfileBench();
+  void CallPathBench();
+  void ListBench();
+  void ScanBench();
+  void StreamBench();
+  void DispatchBench();
+  void FieldBench();
+  void BroadcastBench();
+  void InterpreterBench();
+  void BytecodeBench();
+}
+
+//=================================================================================================
+
+#endif // INTERPP_BENCH_H
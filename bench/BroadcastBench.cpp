@@ -0,0 +1,125 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  class Gain
+  {
+  public:
+    long long Apply( long long sample, int gain )
+    {
+      return sample * gain + 1;
+    }
+
+    // for checking that broadcast arguments convert as they would in a plain call
+    int Scale( int sample, int gain )
+    {
+      return sample * gain;
+    }
+
+    char Initial( char initial )
+    {
+      return initial;
+    }
+
+    std::string Echo( std::string text )
+    {
+      return text;
+    }
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Gain, Apply, long long, long long, int )
+INTERPP_REGISTER_METHOD_RETURN( Gain, Scale, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Gain, Initial, char, char )
+INTERPP_REGISTER_METHOD_RETURN( Gain, Echo, std::string, std::string )
+
+//=================================================================================================
+
+void Bench::BroadcastBench()
+{
+  const unsigned long sampleCount = 100000;
+  const unsigned long rounds = 5;
+
+  Gain gain;
+  Interpp::RegisterObject( gain, "gain" );
+
+  std::string broadcast = "gain.Apply( range( 0, " + std::to_string( sampleCount ) + " ), 3 )";
+  std::vector< std::string > commands;
+
+  for( unsigned long i = 0; i < sampleCount; ++i )
+  {
+    commands.push_back( "gain.Apply( " + std::to_string( i ) + ", 3 )" );
+  }
+
+  // one Execute() per element, gathered into the list a broadcast returns
+  std::string expected;
+
+  Report( "Execute for each element, per element", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    expected = "[";
+
+    for( unsigned long i = 0; i < sampleCount; ++i )
+    {
+      expected += i == 0 ? "" : ", ";
+      expected += Interpp::Execute( commands[i] );
+    }
+
+    expected += ']';
+  } ), sampleCount ) );
+
+  std::string result;
+
+  Report( "broadcast Execute, per element", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    result = Interpp::Execute( broadcast );
+  } ), sampleCount ) );
+
+  if( result != expected )
+  {
+    Fail( "broadcast result differs from Execute per element" );
+  }
+
+  Interpp::ParallelExecutor executor;
+
+  Report( "broadcast ParallelExecutor (" + std::to_string( executor.ThreadCount() ) + " threads), per element", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    result = executor.Execute( broadcast );
+  } ), sampleCount ) );
+
+  if( result != expected )
+  {
+    Fail( "ParallelExecutor broadcast result differs from Execute per element" );
+  }
+
+  if( Interpp::Execute( "gain.Apply( range( 0, 3 ), range( 0, 4 ) )" ).compare( 0, 6, "Error:" ) != 0 )
+  {
+    Fail( "broadcast over ranges of different lengths did not fail" );
+  }
+
+  // each element gets the text a plain call would get, e.g. gain.Echo( 1.50 ) gives 1.50
+  const char* conversions[][2] =
+  {
+    { "gain.Scale( range( 0, 2 ), 1.0 )", "Error: invalid param 2" },
+    { "gain.Scale( range( 0, 2 ), +-5 )", "Error: invalid param 2" },
+    { "gain.Scale( each( [1, 2.5] ), 2 )", "Error: invalid param 1" },
+    { "gain.Scale( range( 1, 3 ), '4' )", "[4, 8]" },
+    { "gain.Initial( each( [7, 'x'] ) )", "['7', 'x']" },
+    { "gain.Echo( each( [1.50, -0, 'a b'] ) )", "['1.50', '-0', 'a b']" },
+    { "gain.Echo( range( 0, 0.3, 0.1 ) )", "['0', '0.1', '0.2']" }
+  };
+
+  for( const auto& conversion : conversions )
+  {
+    if( Interpp::Execute( conversion[0] ) != conversion[1] )
+    {
+      Fail( std::string( conversion[0] ) + " gave " + Interpp::Execute( conversion[0] ) + ", not " + conversion[1] );
+    }
+  }
+}
+
+//=================================================================================================
@@ -0,0 +1,251 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <cstdio>
+#include <sstream>
+
+//=================================================================================================
+
+namespace
+{
+  // what a startup script typically drives: named settings of a few types
+  class Settings
+  {
+  public:
+    void SetInt( std::string name, int value )
+    {
+      total += ( long long ) name.size() + value;
+    }
+
+    void SetReal( std::string name, double value )
+    {
+      total += ( long long ) ( name.size() + value );
+    }
+
+    bool Enable( std::string name, bool enabled )
+    {
+      return enabled && !name.empty();
+    }
+
+    long long total = 0;
+  };
+
+  // methods whose params a constant could be converted for wrongly
+  class Probe
+  {
+  public:
+    int Add( int a, int b )
+    {
+      return a + b;
+    }
+
+    char C( char c )
+    {
+      return c;
+    }
+
+    std::string Echo( std::string text )
+    {
+      return text;
+    }
+
+    int Id()
+    {
+      return id;
+    }
+
+    int id = 0;
+  };
+}
+
+INTERPP_REGISTER_METHOD_VOID( Settings, SetInt, std::string, int )
+INTERPP_REGISTER_METHOD_VOID( Settings, SetReal, std::string, double )
+INTERPP_REGISTER_METHOD_RETURN( Settings, Enable, bool, std::string, bool )
+INTERPP_REGISTER_METHOD_RETURN( Probe, Add, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Probe, C, char, char )
+INTERPP_REGISTER_METHOD_RETURN( Probe, Echo, std::string, std::string )
+INTERPP_REGISTER_METHOD_RETURN( Probe, Id, int )
+
+//=================================================================================================
+
+namespace
+{
+  bool WriteFile( const char* path, const std::string& data )
+  {
+    FILE* file = std::fopen( path, "wb" );
+    bool written = file != NULL && std::fwrite( data.data(), 1, data.size(), file ) == data.size();
+
+    if( file != NULL )
+    {
+      std::fclose( file );
+    }
+
+    return written;
+  }
+}
+
+//=================================================================================================
+
+void Bench::BytecodeBench()
+{
+  const unsigned long commandCount = 20000;
+  const unsigned long rounds = 10;
+  const char* textPath = "interpp_bytecode_bench.txt";
+  const char* bytecodePath = "interpp_bytecode_bench.ipbc";
+
+  Settings settings;
+  Interpp::RegisterObject( settings, "settings" );
+
+  std::string commandLines;
+
+  for( unsigned long i = 0; i < commandCount; ++i )
+  {
+    std::string name = "'module" + std::to_string( i % 97 ) + ".option" + std::to_string( i ) + "'";
+    commandLines += i % 3 == 0 ? "settings.SetInt( " + name + ", " + std::to_string( i ) + " )\n" :
+                    i % 3 == 1 ? "settings.SetReal( " + name + ", " + std::to_string( i ) + ".25 )\n" :
+                                 "settings.Enable( " + name + ", true )\n";
+  }
+
+  std::string bytecode;
+  std::string error;
+
+  if( !Interpp::CompileBytecode( commandLines, bytecode, error ) || !WriteFile( textPath, commandLines ) ||
+      !WriteFile( bytecodePath, bytecode ) )
+  {
+    Fail( "could not compile or write the startup script: " + error );
+    return;
+  }
+
+  Report( "bytecode size, per command", ( double ) bytecode.size() / commandCount, "bytes" );
+
+  // how startup scripts are run now: each line parsed and executed
+  std::string expected;
+
+  Report( "text, getline + Execute, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    std::istringstream input( commandLines );
+    std::string command;
+    expected.clear();
+
+    while( std::getline( input, command ) )
+    {
+      expected += Interpp::Execute( command );
+      expected += '\n';
+    }
+  } ), commandCount ) );
+
+  Interpp::BatchResults results;
+
+  Report( "text, ExecuteBatch, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    Interpp::ExecuteBatch( commandLines, results );
+  } ), commandCount ) );
+
+  // startup from bytecode: map, validate and link the file, then run it
+  Interpp::BytecodeProgram program;
+
+  Report( "bytecode, load + run, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    if( !program.Load( bytecodePath, error ) )
+    {
+      Fail( "could not load bytecode: " + error );
+    }
+
+    program.Run( results );
+  } ), commandCount ) );
+
+  Report( "bytecode, run only, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    program.Run( results );
+  } ), commandCount ) );
+
+  std::string actual;
+
+  for( unsigned long i = 0; i < results.Size(); ++i )
+  {
+    actual.append( results[i] );
+    actual += '\n';
+  }
+
+  if( program.CommandCount() != commandCount || actual != expected )
+  {
+    Fail( "bytecode results differ from Execute" );
+  }
+
+  // each param gets the text a plain call would get, e.g. probe.Echo( 1.50 ) gives 1.50
+  Probe probe;
+  Interpp::RegisterObject( probe, "probe" );
+
+  const char* conversions[][2] =
+  {
+    { "probe.Add( 1.0, 2 )", "Error: invalid param 1" },
+    { "probe.Add( 1 )", "1" },
+    { "probe.Add( '1', 2 )", "3" },
+    { "probe.C( 7 )", "7" },
+    { "probe.Echo( 1.50 )", "1.50" },
+    { "probe.Echo( -0 )", "-0" },
+    { "probe.Echo( true )", "true" },
+    { "probe.Echo( 'a b' )", "a b" },
+    { "probe.Echo()", "" }
+  };
+
+  for( const auto& conversion : conversions )
+  {
+    std::string compiled;
+
+    if( !Interpp::CompileBytecode( conversion[0], compiled, error ) || !program.Load( compiled, error ) )
+    {
+      Fail( std::string( "could not compile or load " ) + conversion[0] + ": " + error );
+      continue;
+    }
+
+    program.Run( results );
+
+    if( results.Size() != 1 || results[0] != conversion[1] || Interpp::Execute( conversion[0] ) != conversion[1] )
+    {
+      Fail( std::string( conversion[0] ) + " gave " + std::string( results.Size() == 1 ? results[0] : "no result" ) + " from bytecode and " +
+            Interpp::Execute( conversion[0] ) + " from Execute, not " + conversion[1] );
+    }
+  }
+
+  // compiled calls follow the name when another object is registered under it after the load
+  std::string compiled;
+  Interpp::CompiledCommand command = Interpp::Compile( "probe.Id()" );
+
+  if( !Interpp::CompileBytecode( "probe.Id()", compiled, error ) || !program.Load( compiled, error ) )
+  {
+    Fail( "could not compile or load probe.Id(): " + error );
+  }
+
+  Probe replacement;
+  replacement.id = 1;
+  Interpp::RegisterObject( replacement, "probe" );
+  program.Run( results );
+
+  if( results.Size() != 1 || results[0] != "1" || command.Execute() != "Error: object not found" )
+  {
+    Fail( "a re-registered object gave " + std::string( results.Size() == 1 ? results[0] : "no result" ) + " from bytecode and " +
+          command.Execute() + " from a compiled command" );
+  }
+
+  Interpp::RegisterObject( probe, "probe" );
+
+  if( command.Execute() != "0" )
+  {
+    Fail( "a compiled command gave " + command.Execute() + " once its object was registered again" );
+  }
+
+  Interpp::UnregisterObject( "probe" );
+
+  // a damaged file must be rejected, not run
+  if( program.Load( std::string_view( bytecode ).substr( 0, bytecode.size() - 1 ), error ) ||
+      program.Load( std::string_view( bytecode ).substr( 1 ), error ) )
+  {
+    Fail( "damaged bytecode was loaded" );
+  }
+
+  std::remove( textPath );
+  std::remove( bytecodePath );
+}
+
+//=================================================================================================
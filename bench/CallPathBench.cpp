@@ -0,0 +1,306 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  class Arity
+  {
+  public:
+    int A0() { return 0; }
+    int A1( int a ) { return a; }
+    int A2( int a, int b ) { return a + b; }
+    int A3( int a, int b, int c ) { return a + b + c; }
+    int A4( int a, int b, int c, int d ) { return a + b + c + d; }
+    int A5( int a, int b, int c, int d, int e ) { return a + b + c + d + e; }
+    int A6( int a, int b, int c, int d, int e, int f ) { return a + b + c + d + e + f; }
+    int A7( int a, int b, int c, int d, int e, int f, int g ) { return a + b + c + d + e + f + g; }
+    int A8( int a, int b, int c, int d, int e, int f, int g, int h ) { return a + b + c + d + e + f + g + h; }
+    int A9( int a, int b, int c, int d, int e, int f, int g, int h, int i ) { return a + b + c + d + e + f + g + h + i; }
+    int A10( int a, int b, int c, int d, int e, int f, int g, int h, int i, int j ) { return a + b + c + d + e + f + g + h + i + j; }
+  };
+
+  class Node
+  {
+  public:
+    int Get()
+    {
+      return 1;
+    }
+
+    // too long for std::string's inline buffer, and returned without a copy, so that any allocation
+    // is Interpp's
+    const std::string& Describe()
+    {
+      return _description;
+    }
+
+  private:
+    std::string _description = "node, with a description longer than 15 characters";
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Arity, A0, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A1, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A2, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A3, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A4, int, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A5, int, int, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A6, int, int, int, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A7, int, int, int, int, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A8, int, int, int, int, int, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A9, int, int, int, int, int, int, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Arity, A10, int, int, int, int, int, int, int, int, int, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Node, Get, int )
+INTERPP_REGISTER_METHOD_RETURN( Node, Describe, const std::string& )
+
+//=================================================================================================
+
+namespace
+{
+  const unsigned long iterations = 1000000;
+
+  // steady-state calls draw their temporaries from the per-thread call arena, not the heap
+  void ExpectNoAllocations( const std::string& name )
+  {
+    if( Bench::allocsPerOp != 0 )
+    {
+      Bench::Fail( name + " made " + std::to_string( Bench::allocsPerOp ) + " heap allocations per op" );
+    }
+  }
+
+  // Execute end-to-end, once per arity
+  void BenchArities()
+  {
+    static Arity arity;
+    Interpp::RegisterObject( arity, "arity" );
+
+    for( int args = 0; args <= 10; ++args )
+    {
+      std::string command = "arity.A" + std::to_string( args ) + "(";
+
+      for( int i = 1; i <= args; ++i )
+      {
+        command += ( i == 1 ? " " : ", " ) + std::to_string( i );
+      }
+
+      command += args == 0 ? ")" : " )";
+
+      if( Interpp::Execute( command ) != std::to_string( args * ( args + 1 ) / 2 ) )
+      {
+        Bench::Fail( command + " returned " + Interpp::Execute( command ) );
+      }
+
+      Bench::Report( "Execute, arity " + std::to_string( args ), Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        Bench::sink += Interpp::Execute( command ).size();
+      } ) );
+
+      ExpectNoAllocations( command );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void BenchParamList()
+  {
+    const char* const paramLists[][2] =
+    {
+      { "1 param", "42" },
+      { "4 params", "1, 2.5, true, 'text'" },
+      { "10 params", "1, 2, 3, 4, 5, 6, 7, 8, 9, 10" },
+      { "20 params (beyond the inline capacity)", "1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20" },
+      { "quoted, with commas and escapes", "'a, b', 'it\\'s', ' spaced '" },
+    };
+
+    for( unsigned long i = 0; i < sizeof( paramLists ) / sizeof( paramLists[0] ); ++i )
+    {
+      std::string_view params = paramLists[i][1];
+
+      Bench::Report( std::string( "_ParamList, " ) + paramLists[i][0], Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        Bench::sink += Interpp::_ParamList( params ).Size();
+      } ) );
+
+      // as within Execute(), once the arena has grown to fit
+      {
+        Interpp::_ArenaScope arena;
+        Bench::sink += Interpp::_ParamList( params ).Size();
+      }
+
+      Bench::Report( std::string( "_ParamList, " ) + paramLists[i][0] + ", call arena", Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        Interpp::_ArenaScope arena;
+        Bench::sink += Interpp::_ParamList( params ).Size();
+      } ) );
+
+      ExpectNoAllocations( std::string( "_ParamList, " ) + paramLists[i][0] );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Execute() returning a new string, against the overloads that write into the caller's buffer
+  // and return a status
+  void BenchStatus()
+  {
+    static Node node;
+    Interpp::RegisterObject( node, "described" );
+
+    const char* const commands[] = { "described.Describe()", "described.Get()", "missing.Get()" };
+    const Interpp::ExecuteStatus statuses[] = { Interpp::ExecuteOk, Interpp::ExecuteOk, Interpp::ExecuteObjectNotFound };
+
+    std::string result;
+    char buffer[64];
+    std::size_t size;
+
+    for( unsigned long i = 0; i < sizeof( commands ) / sizeof( commands[0] ); ++i )
+    {
+      std::string_view command = commands[i];
+
+      result.clear();
+
+      if( Interpp::Execute( command, result ) != statuses[i] || Interpp::Execute( command, buffer, sizeof( buffer ), size ) != statuses[i] ||
+          ( statuses[i] == Interpp::ExecuteOk && ( result != Interpp::Execute( command ) || std::string_view( buffer, size ) != result ) ) )
+      {
+        Bench::Fail( std::string( command ) + " did not report " + Interpp::ExecuteStatusText( statuses[i] ) );
+      }
+
+      Bench::Report( std::string( command ) + ", Execute, new string", Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        Bench::sink += Interpp::Execute( command ).size();
+      } ) );
+
+      Bench::Report( std::string( command ) + ", Execute, reused string", Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        result.clear();
+        Bench::sink += Interpp::Execute( command, result );
+      } ) );
+
+      ExpectNoAllocations( std::string( command ) + " into a reused string" );
+
+      Bench::Report( std::string( command ) + ", Execute, char buffer", Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        Bench::sink += Interpp::Execute( command, buffer, sizeof( buffer ), size );
+      } ) );
+
+      ExpectNoAllocations( std::string( command ) + " into a char buffer" );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // a batch's resolution cache and its params come from the call arena, and its results buffer is
+  // reused, so repeated batches make no allocations
+  void BenchBatches()
+  {
+    const unsigned long commandCount = 64;
+
+    std::vector< std::string > commands;
+
+    for( unsigned long i = 0; i < commandCount; ++i )
+    {
+      commands.push_back( "arity.A" + std::to_string( i % 11 ) + "( 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 )" );
+    }
+
+    Interpp::BatchResults results;
+    Interpp::ExecuteBatch( commands.data(), commandCount, results );
+
+    Bench::Report( "ExecuteBatch, 64 commands, per command", Bench::PerItem( Bench::NsPerOp( iterations / commandCount, [&]( unsigned long )
+    {
+      Interpp::ExecuteBatch( commands.data(), commandCount, results );
+      Bench::sink += results.Size();
+    } ), commandCount ) );
+
+    ExpectNoAllocations( "ExecuteBatch" );
+
+    Interpp::ParallelExecutor executor( 1 );
+    executor.ExecuteBatch( commands.data(), commandCount, results );
+
+    Bench::Report( "ParallelExecutor, 64 commands, per command", Bench::PerItem( Bench::NsPerOp( iterations / commandCount, [&]( unsigned long )
+    {
+      executor.ExecuteBatch( commands.data(), commandCount, results );
+      Bench::sink += results.Size();
+    } ), commandCount ) );
+
+    ExpectNoAllocations( "ParallelExecutor::ExecuteBatch" );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // lookups with objectCount objects registered by this group (on top of any registered before)
+  void BenchRegistryScale( unsigned long objectCount, std::vector< Node >& nodes, std::vector< std::string >& names )
+  {
+    {
+      Interpp::RegistrationBatch batch;
+
+      for( unsigned long i = nodes.size(); i < objectCount; ++i )
+      {
+        names.push_back( "node" + std::to_string( i ) );
+      }
+
+      nodes.resize( objectCount );
+
+      for( unsigned long i = 0; i < objectCount; ++i )
+      {
+        Interpp::RegisterObject( nodes[i], names[i] );
+      }
+    }
+
+    std::string count = std::to_string( objectCount );
+
+    Bench::Report( "GetObject, " + count + " objects", Bench::NsPerOp( iterations, [&]( unsigned long i )
+    {
+      Bench::sink += Interpp::_InterppRegistry::GetObject( names[( i * 7919 ) % objectCount] ) != NULL;
+    } ) );
+
+    Bench::Report( "GetMethod, " + count + " objects", Bench::NsPerOp( iterations, [&]( unsigned long i )
+    {
+      Bench::sink += Interpp::_InterppRegistry::GetMethod( names[( i * 7919 ) % objectCount], "Get" ).call != NULL;
+    } ) );
+
+    Bench::Report( "GetObject miss, " + count + " objects", Bench::NsPerOp( iterations, []( unsigned long )
+    {
+      Bench::sink += Interpp::_InterppRegistry::GetObject( "node_missing" ) != NULL;
+    } ) );
+  }
+}
+
+//=================================================================================================
+
+void Bench::CallPathBench()
+{
+  BenchArities();
+  BenchParamList();
+  BenchStatus();
+  BenchBatches();
+
+  std::vector< Node > nodes;
+  std::vector< std::string > names;
+
+  nodes.reserve( 100000 );
+  BenchRegistryScale( 10, nodes, names );
+  BenchRegistryScale( 1000, nodes, names );
+  BenchRegistryScale( 100000, nodes, names );
+
+  // leave the registry as it was, so that later groups do not run against 100000 extra objects
+  {
+    Interpp::RegistrationBatch batch;
+
+    for( unsigned long i = 0; i < names.size(); ++i )
+    {
+      Interpp::UnregisterObject( names[i] );
+    }
+  }
+
+  if( Interpp::_InterppRegistry::GetObject( names.back() ) != NULL )
+  {
+    Fail( "callpath nodes are still registered" );
+  }
+}
+
+//=================================================================================================
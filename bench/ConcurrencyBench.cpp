@@ -0,0 +1,155 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+//=================================================================================================
+
+namespace
+{
+  class Calculator
+  {
+  public:
+    int Add( int x, int y )
+    {
+      return x + y;
+    }
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Calculator, Add, int, int, int )
+
+//=================================================================================================
+
+namespace
+{
+  const unsigned long objectCount = 64;
+
+  Calculator calculators[objectCount];
+
+  unsigned long MaxThreads()
+  {
+    unsigned long threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 4 : threads;
+  }
+
+  std::string AddCommand( unsigned long object, unsigned long x, unsigned long y )
+  {
+    return "calc" + std::to_string( object ) + ".Add( " + std::to_string( x ) + ", " + std::to_string( y ) + " )";
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Readers hammer Execute() while a writer keeps registering new objects, so every lookup races
+  // with snapshot publication and reclamation. Every result is checked.
+  void StressTest()
+  {
+    const unsigned long callsPerThread = 200000;
+    const unsigned long threadCount = MaxThreads() < 2 ? 2 : MaxThreads();
+
+    std::atomic< bool > writing( true );
+    std::atomic< unsigned long > mismatches( 0 );
+    unsigned long registrations = 0;
+
+    std::vector< std::thread > readers;
+
+    for( unsigned long t = 0; t < threadCount; ++t )
+    {
+      readers.push_back( std::thread( [&, t]()
+      {
+        for( unsigned long i = 0; i < callsPerThread; ++i )
+        {
+          unsigned long object = ( i + t ) % objectCount;
+
+          if( Interpp::Execute( AddCommand( object, i, t ) ) != std::to_string( i + t ) )
+          {
+            mismatches++;
+          }
+        }
+      } ) );
+    }
+
+    std::thread writer( [&]()
+    {
+      static Calculator extra;
+
+      while( writing.load() )
+      {
+        Interpp::RegisterObject( extra, "extra" + std::to_string( registrations++ % 1000 ) );
+      }
+    } );
+
+    for( unsigned long t = 0; t < readers.size(); ++t )
+    {
+      readers[t].join();
+    }
+
+    writing.store( false );
+    writer.join();
+
+    if( mismatches.load() != 0 )
+    {
+      Bench::Fail( "concurrent Execute returned " + std::to_string( mismatches.load() ) + " wrong results" );
+    }
+    else
+    {
+      std::cout << "stress: " << threadCount << " readers x " << callsPerThread << " calls against "
+                << registrations << " concurrent registrations, all results correct\n";
+    }
+  }
+}
+
+//=================================================================================================
+
+void Bench::ConcurrencyBench()
+{
+  for( unsigned long i = 0; i < objectCount; ++i )
+  {
+    Interpp::RegisterObject( calculators[i], "calc" + std::to_string( i ) );
+  }
+
+  StressTest();
+
+  // scaling: aggregate wall time per Execute() as reader threads are added
+  const unsigned long callsPerThread = 500000;
+
+  std::vector< std::string > commands;
+
+  for( unsigned long i = 0; i < 1024; ++i )
+  {
+    commands.push_back( AddCommand( i % objectCount, i, 2 * i ) );
+  }
+
+  for( unsigned long threadCount = 1; threadCount <= MaxThreads(); threadCount *= 2 )
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector< std::thread > threads;
+
+    for( unsigned long t = 0; t < threadCount; ++t )
+    {
+      threads.push_back( std::thread( [&, t]()
+      {
+        unsigned long sum = 0;
+
+        for( unsigned long i = 0; i < callsPerThread; ++i )
+        {
+          sum += Interpp::Execute( commands[( i + t ) & 1023] ).size();
+        }
+
+        sink += sum;
+      } ) );
+    }
+
+    for( unsigned long t = 0; t < threads.size(); ++t )
+    {
+      threads[t].join();
+    }
+
+    std::chrono::duration< double, std::nano > elapsed = std::chrono::steady_clock::now() - start;
+    Report( "Execute, " + std::to_string( threadCount ) + " thread(s), aggregate", elapsed.count() / ( threadCount * callsPerThread ) );
+  }
+}
+
+//=================================================================================================
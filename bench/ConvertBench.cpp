@@ -0,0 +1,188 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <cstdlib>
+#include <sstream>
+#include <type_traits>
+
+//=================================================================================================
+
+namespace
+{
+  const unsigned long iterations = 2000000;
+
+  // The atoi/atof and ostringstream chain ConvertValue used before ValueConverter, kept here for
+  // comparison; its typeid tests become if constexpr so that no branch reinterprets one type as
+  // another
+  template< class ToType, class FromType >
+  ToType LegacyConvertValue( FromType fromValue )
+  {
+    if constexpr( std::is_same< FromType, std::string >::value )
+    {
+      std::string fromString = fromValue;
+
+      if constexpr( std::is_same< ToType, std::string >::value )
+      {
+        return fromString;
+      }
+      else if constexpr( std::is_same< ToType, char >::value )
+      {
+        return fromString[0];
+      }
+      else if constexpr( std::is_same< ToType, unsigned char >::value )
+      {
+        return ( unsigned char ) atoi( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, double >::value )
+      {
+        return atof( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, float >::value )
+      {
+        return ( float ) atof( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, int >::value )
+      {
+        return atoi( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, short >::value )
+      {
+        return ( short ) atoi( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, long >::value )
+      {
+        return atol( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, unsigned int >::value )
+      {
+        return ( unsigned int ) atoi( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, unsigned short >::value )
+      {
+        return ( unsigned short ) atoi( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, unsigned long >::value )
+      {
+        return ( unsigned long ) atol( fromString.c_str() );
+      }
+      else if constexpr( std::is_same< ToType, bool >::value )
+      {
+        return fromString == "true";
+      }
+      else
+      {
+        return ToType();
+      }
+    }
+    else if constexpr( std::is_same< ToType, std::string >::value )
+    {
+      std::ostringstream returnStream;
+
+      if constexpr( std::is_same< FromType, unsigned char >::value )
+      {
+        returnStream << ( unsigned short ) fromValue;
+      }
+      else if constexpr( std::is_same< FromType, bool >::value )
+      {
+        returnStream << ( fromValue ? "true" : "false" );
+      }
+      else if constexpr( std::is_same< FromType, char >::value ||
+                         std::is_same< FromType, double >::value ||
+                         std::is_same< FromType, float >::value ||
+                         std::is_same< FromType, int >::value ||
+                         std::is_same< FromType, short >::value ||
+                         std::is_same< FromType, long >::value ||
+                         std::is_same< FromType, unsigned int >::value ||
+                         std::is_same< FromType, unsigned short >::value ||
+                         std::is_same< FromType, unsigned long >::value )
+      {
+        returnStream << fromValue;
+      }
+
+      return returnStream.str();
+    }
+    else
+    {
+      return ToType();
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // times text -> Type and Type -> text, through ValueConverter and, for the types it supported,
+  // through the legacy chain
+  template< class Type >
+  void BenchType( const std::string& typeName, const std::string& text, bool legacy = true )
+  {
+    Type value = Type();
+    Interpp::ConvertValue( text, value );
+
+    Bench::Report( "text -> " + typeName + ", ValueConverter", Bench::NsPerOp( iterations, [&]( unsigned long )
+    {
+      Type converted = Type();
+      Interpp::ConvertValue( text, converted );
+      Bench::sink += ( unsigned long ) converted;
+    } ) );
+
+    if( legacy )
+    {
+      Bench::Report( "text -> " + typeName + ", legacy", Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        Bench::sink += ( unsigned long ) LegacyConvertValue< Type >( text );
+      } ) );
+    }
+
+    Bench::Report( typeName + " -> text, ValueConverter", Bench::NsPerOp( iterations, [&]( unsigned long )
+    {
+      Bench::sink += Interpp::ConvertValue< std::string >( value ).size();
+    } ) );
+
+    if( legacy )
+    {
+      Bench::Report( typeName + " -> text, legacy", Bench::NsPerOp( iterations, [&]( unsigned long )
+      {
+        Bench::sink += LegacyConvertValue< std::string >( value ).size();
+      } ) );
+    }
+  }
+}
+
+//=================================================================================================
+
+void Bench::ConvertBench()
+{
+  BenchType< char >( "char", "c" );
+  BenchType< unsigned char >( "unsigned char", "200" );
+  BenchType< short >( "short", "-12345" );
+  BenchType< unsigned short >( "unsigned short", "54321" );
+  BenchType< int >( "int", "-123456789" );
+  BenchType< unsigned int >( "unsigned int", "3123456789" );
+  BenchType< long >( "long", "-1234567890123" );
+  BenchType< unsigned long >( "unsigned long", "1234567890123" );
+  BenchType< long long >( "long long", "-1234567890123456", false );
+  BenchType< unsigned long long >( "unsigned long long", "12345678901234567890", false );
+  BenchType< float >( "float", "3.14159" );
+  BenchType< double >( "double", "-2.718281828459045" );
+  BenchType< bool >( "bool", "true" );
+
+  std::string text = "a string param";
+
+  Report( "text -> std::string, ValueConverter", NsPerOp( iterations, [&]( unsigned long )
+  {
+    std::string converted;
+    Interpp::ConvertValue( text, converted );
+    sink += converted.size();
+  } ) );
+
+  Report( "text -> std::string, legacy", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += LegacyConvertValue< std::string >( text ).size();
+  } ) );
+
+  Report( "std::string -> text, ValueConverter", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::ConvertValue< std::string >( text ).size();
+  } ) );
+}
+
+//=================================================================================================
@@ -0,0 +1,126 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+//=================================================================================================
+
+namespace
+{
+  class Shape
+  {
+  public:
+    virtual ~Shape() {}
+
+    virtual double Area()
+    {
+      return 0.0;
+    }
+
+    int Sides()
+    {
+      return sides;
+    }
+
+    int sides = 0;
+  };
+
+  class Polygon : public Shape
+  {
+  };
+
+  class Square : public Polygon
+  {
+  public:
+    Square()
+    {
+      sides = 4;
+    }
+
+    double Area()
+    {
+      return 4.0;
+    }
+
+    int Side()
+    {
+      return 2;
+    }
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Shape, Area, double )
+INTERPP_REGISTER_METHOD_RETURN( Shape, Sides, int )
+INTERPP_REGISTER_METHOD_RETURN( Square, Side, int )
+
+INTERPP_REGISTER_BASE( Polygon, Shape )
+INTERPP_REGISTER_BASE( Square, Polygon )
+
+//=================================================================================================
+
+void Bench::DispatchBench()
+{
+  const unsigned long iterations = 1000000;
+
+  Square square;
+  Interpp::RegisterObject( square, "square" );
+
+  if( Interpp::Execute( "square.Area()" ) != "4" || Interpp::Execute( "square.Sides()" ) != "4" )
+  {
+    Fail( "methods inherited by Square do not dispatch to it" );
+  }
+
+  Report( "Execute, own method", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Execute( "square.Side()" ).size();
+  } ) );
+
+  Report( "Execute, method two bases up", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Execute( "square.Sides()" ).size();
+  } ) );
+
+  // typed calls: resolved on every call, through a CallSite's inline cache, and bound once
+  Report( "Resolve + Invoke per call", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Resolve( "square", "Sides" ).Invoke().AsInt();
+  } ) );
+
+  Interpp::CallSite site( "square", "Sides" );
+
+  Report( "CallSite::Invoke", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += site.Invoke().AsInt();
+  } ) );
+
+  Interpp::TypedMethod method = Interpp::Resolve( "square", "Sides" );
+
+  Report( "TypedMethod bound once", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += method.Invoke().AsInt();
+  } ) );
+
+  if( site.Stats().misses != 1 || site.Stats().hits != iterations - 1 )
+  {
+    Fail( "CallSite missed its inline cache with the registry unchanged" );
+  }
+
+  // every registration sends the site back to the registry for the object, but not for the method
+  Square other;
+  Interpp::CallSite rebound( "current", "Sides" );
+
+  for( unsigned long i = 0; i < 1000; ++i )
+  {
+    Interpp::RegisterObject( i % 2 == 0 ? square : other, "current" );
+    sink += rebound.Invoke().AsInt();
+  }
+
+  const Interpp::InlineCacheStats& stats = rebound.Stats();
+  Report( "CallSite hit rate, two objects alternating", 100.0 * stats.hits / ( stats.hits + stats.misses ), "%" );
+
+  if( stats.misses != 2 )
+  {
+    Fail( "CallSite resolved a method again for an object it had seen" );
+  }
+}
+
+//=================================================================================================
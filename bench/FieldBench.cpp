@@ -0,0 +1,101 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+//=================================================================================================
+
+namespace
+{
+  class Pump
+  {
+  public:
+    // the trivial accessors fields used to need, for comparison
+    double GetPressure()
+    {
+      return pressure;
+    }
+
+    void SetPressure( double value )
+    {
+      pressure = value;
+    }
+
+    double pressure = 2.5;
+    double flow = 14.25;
+    int rpm = 1800;
+    bool running = true;
+    std::string mode = "auto";
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Pump, GetPressure, double )
+INTERPP_REGISTER_METHOD_VOID( Pump, SetPressure, double )
+
+INTERPP_REGISTER_FIELD( Pump, pressure, double )
+INTERPP_REGISTER_FIELD( Pump, flow, double )
+INTERPP_REGISTER_FIELD( Pump, rpm, int )
+INTERPP_REGISTER_FIELD( Pump, running, bool )
+INTERPP_REGISTER_FIELD( Pump, mode, std::string )
+
+//=================================================================================================
+
+void Bench::FieldBench()
+{
+  const unsigned long iterations = 1000000;
+
+  Pump pump;
+  Interpp::RegisterObject( pump, "pump" );
+
+  Report( "read, getter method", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Execute( "pump.GetPressure()" ).size();
+  } ) );
+
+  Report( "read, field", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Execute( "pump.pressure" ).size();
+  } ) );
+
+  Report( "write, setter method", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Execute( "pump.SetPressure( 3.5 )" ).size();
+  } ) );
+
+  Report( "write, field", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Execute( "pump.pressure = 3.5" ).size();
+  } ) );
+
+  if( Interpp::Execute( "pump.pressure" ) != "3.5" )
+  {
+    Fail( "field write did not reach the object" );
+  }
+
+  // a monitoring scrape of every field: one command per field, against one snapshot
+  const char* fieldReads[] = { "pump.pressure", "pump.flow", "pump.rpm", "pump.running", "pump.mode" };
+  std::string scrape;
+
+  Report( "scrape 5 fields, one read each", NsPerOp( iterations / 5, [&]( unsigned long )
+  {
+    scrape.clear();
+
+    for( const char* read : fieldReads )
+    {
+      Interpp::Execute( read, scrape );
+      scrape += ' ';
+    }
+  } ) );
+
+  Report( "scrape 5 fields, pump.*", NsPerOp( iterations / 5, [&]( unsigned long )
+  {
+    scrape.clear();
+    Interpp::Execute( "pump.*", scrape );
+  } ) );
+
+  if( scrape != "pressure=3.5, flow=14.25, rpm=1800, running=true, mode='auto'" )
+  {
+    Fail( "unexpected snapshot: " + scrape );
+  }
+}
+
+//=================================================================================================
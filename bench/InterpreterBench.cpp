@@ -0,0 +1,223 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+//=================================================================================================
+
+namespace
+{
+  class Session
+  {
+  public:
+    int Touch( int value )
+    {
+      return value + id;
+    }
+
+    int id;
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Session, Touch, int, int )
+
+//=================================================================================================
+
+namespace
+{
+  const unsigned long sessionsPerThread = 128;
+  const unsigned long rounds = 8;
+  const unsigned long callsPerSession = 16;
+
+  unsigned long ThreadCount()
+  {
+    unsigned long threads = std::thread::hardware_concurrency();
+    return threads < 2 ? 2 : threads;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Each thread serves its own tenant: it registers a round of sessions, calls each a few times and
+  // unregisters them again. With one interpreter shared by all threads every registration copies, and
+  // waits for, all threads' sessions; with one interpreter per thread, only the thread's own. Both
+  // start empty, so that objects other groups left in Interpreter::Default() do not weigh on either.
+  // Returns the wall time per operation (registrations, calls and unregistrations), aggregated over
+  // threads.
+  double RunTenants( unsigned long threadCount, bool sharded, std::atomic< unsigned long >& mismatches )
+  {
+    Interpp::Interpreter shared;
+    std::vector< std::unique_ptr< Interpp::Interpreter > > interpreters;
+
+    for( unsigned long t = 0; t < threadCount; ++t )
+    {
+      interpreters.push_back( std::unique_ptr< Interpp::Interpreter >( sharded ? new Interpp::Interpreter() : NULL ) );
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector< std::thread > threads;
+
+    for( unsigned long t = 0; t < threadCount; ++t )
+    {
+      threads.push_back( std::thread( [&, t]()
+      {
+        Interpp::Interpreter& interpreter = sharded ? *interpreters[t] : shared;
+        std::vector< Session > sessions( sessionsPerThread );
+        std::vector< std::string > names;
+        std::vector< std::string > commands;
+
+        // names are unique across threads, so that tenants of a shared interpreter do not collide
+        for( unsigned long i = 0; i < sessionsPerThread; ++i )
+        {
+          sessions[i].id = ( int ) ( t * sessionsPerThread + i );
+          names.push_back( "tenant" + std::to_string( t ) + "_" + std::to_string( i ) );
+          commands.push_back( names[i] + ".Touch( 1 )" );
+        }
+
+        for( unsigned long round = 0; round < rounds; ++round )
+        {
+          for( unsigned long i = 0; i < sessionsPerThread; ++i )
+          {
+            interpreter.RegisterObject( sessions[i], names[i] );
+          }
+
+          for( unsigned long i = 0; i < sessionsPerThread * callsPerSession; ++i )
+          {
+            unsigned long session = i % sessionsPerThread;
+
+            if( interpreter.Execute( commands[session] ) != std::to_string( sessions[session].id + 1 ) )
+            {
+              mismatches++;
+            }
+          }
+
+          for( unsigned long i = 0; i < sessionsPerThread; ++i )
+          {
+            interpreter.UnregisterObject( names[i] );
+          }
+        }
+      } ) );
+    }
+
+    for( unsigned long t = 0; t < threads.size(); ++t )
+    {
+      threads[t].join();
+    }
+
+    std::chrono::duration< double, std::nano > elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ( threadCount * rounds * sessionsPerThread * ( callsPerSession + 2 ) );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  class StringSink : public Interpp::StreamSink
+  {
+  public:
+    bool Write( const char* data, std::size_t size )
+    {
+      text.append( data, size );
+      return true;
+    }
+
+    std::string text;
+  };
+
+  // Each way of making a call reaches isolatedSession (id 0) through isolated, and only through it.
+  // Registering in another interpreter leaves isolated's call sites hitting.
+  void CheckEntryPoints( Interpp::Interpreter& isolated, Interpp::ObjectHandle handle )
+  {
+    const std::string command = "isolatedSession.Touch( 2 )";
+    char buffer[16];
+    std::size_t size = 0;
+    Interpp::BatchResults results;
+    StringSink sink;
+
+    Interpp::ParallelExecutor executor( 2, isolated );
+    executor.ExecuteBatch( &command, 1, results );
+
+    {
+      Interpp::StreamRunner runner( sink, 64 * 1024, isolated );
+      runner.Run( std::string_view( command ) );
+    }
+
+    Interpp::Script script = Interpp::CompileScript( "isolatedSession.Touch( 2 )", isolated );
+    Interpp::CallSite site( "isolatedSession", "Touch", isolated );
+    Interpp::Value two( 2 );
+
+    bool reached = isolated.Compile( command ).Execute() == "2" &&
+                   isolated.Resolve( handle, "Touch" ).Invoke( &two, 1 ).AsInt() == 2 &&
+                   isolated.Invoke( "isolatedSession", "Touch", { 2 } ).AsInt() == 2 &&
+                   isolated.Invoke( handle, "Touch", { 2 } ).AsInt() == 2 &&
+                   isolated.Execute( command, buffer, sizeof( buffer ), size ) == Interpp::ExecuteOk &&
+                   std::string( buffer, size ) == "2" &&
+                   isolated.ExecuteAsync( command ).get() == "2" &&
+                   results.Size() == 1 && results[0] == "2" &&
+                   executor.Execute( "isolatedSession.Touch( range( 2, 4 ) )" ) == "[2, 3]" &&
+                   sink.text == "2\n" &&
+                   script.Run().AsInt() == 2 &&
+                   site.Invoke( { 2 } ).AsInt() == 2;
+
+    if( !reached )
+    {
+      Bench::Fail( "a call through an interpreter did not reach its object" );
+    }
+
+    bool leaked = Interpp::Compile( command ).IsValid() ||
+                  Interpp::Invoke( handle, "Touch", { 2 } ).AsInt() == 2 ||
+                  Interpp::ExecuteAsync( command ).get() != "Error: object not found" ||
+                  !Interpp::CompileScript( "isolatedSession.Touch( 2 )" ).Run().IsError() ||
+                  !Interpp::CallSite( "isolatedSession", "Touch" ).Invoke( { 2 } ).IsError();
+
+    if( leaked )
+    {
+      Bench::Fail( "a call through the default interpreter reached another interpreter's object" );
+    }
+
+    Session other = { 0 };
+    Interpp::Interpreter tenant;
+    Interpp::InlineCacheStats before = site.Stats();
+
+    tenant.RegisterObject( other, "otherSession" );
+    site.Invoke( { 2 } );
+
+    if( site.Stats().misses != before.misses )
+    {
+      Bench::Fail( "a registration in one interpreter invalidated another's call site" );
+    }
+  }
+}
+
+//=================================================================================================
+
+void Bench::InterpreterBench()
+{
+  unsigned long threadCount = ThreadCount();
+  std::atomic< unsigned long > mismatches( 0 );
+  std::string threads = std::to_string( threadCount ) + " threads";
+
+  Report( "shared interpreter, " + threads + ", per operation", RunTenants( threadCount, false, mismatches ) );
+  Report( "interpreter per thread, " + threads + ", per operation", RunTenants( threadCount, true, mismatches ) );
+
+  if( mismatches.load() != 0 )
+  {
+    Fail( "tenants saw " + std::to_string( mismatches.load() ) + " wrong results" );
+  }
+
+  // objects of one interpreter are not reachable through another, or through the free functions
+  Session session = { 0 };
+  Interpp::Interpreter isolated;
+  Interpp::ObjectHandle handle = isolated.RegisterObject( session, "isolatedSession" );
+
+  if( isolated.Execute( "isolatedSession.Touch( 2 )" ) != "2" ||
+      Interpp::Execute( "isolatedSession.Touch( 2 )" ) != "Error: object not found" ||
+      Interpp::Interpreter().Execute( "isolatedSession.Touch( 2 )" ) != "Error: object not found" )
+  {
+    Fail( "an interpreter's objects were not isolated" );
+  }
+
+  CheckEntryPoints( isolated, handle );
+}
+
+//=================================================================================================
@@ -0,0 +1,144 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  class Weights
+  {
+  public:
+    unsigned long SetWeights( const std::vector< double >& weights )
+    {
+      _weights = weights;
+      return _weights.size();
+    }
+
+  private:
+    std::vector< double > _weights;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Type >
+  std::string MakeList( unsigned long elementCount, Type first, Type step )
+  {
+    std::vector< Type > elements;
+
+    for( unsigned long i = 0; i < elementCount; ++i )
+    {
+      elements.push_back( first + step * ( Type ) ( i % 1000 ) );
+    }
+
+    return Interpp::ConvertValue< std::string >( elements );
+  }
+
+  // splitting the list with _ParamList, as lists that hold quotes or brackets are split
+  template< class Type >
+  bool ConvertByParamList( const std::string& text, std::vector< Type >& values )
+  {
+    Interpp::_ParamList params( std::string_view( text ).substr( 1, text.size() - 2 ) );
+    values.resize( params.Size() );
+
+    for( unsigned long i = 0; i < params.Size(); ++i )
+    {
+      if( !Interpp::ConvertValue( params[i], values[i] ) )
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  double MegabytesPerSecond( double nsPerOp, std::size_t bytes )
+  {
+    return bytes / nsPerOp * 1e9 / 1e6;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Type >
+  void BenchList( const std::string& typeName, unsigned long elementCount, Type first, Type step )
+  {
+    std::string text = MakeList( elementCount, first, step );
+    std::string count = std::to_string( elementCount );
+    unsigned long iterations = 20000000 / text.size() + 1;
+
+    std::vector< Type > scanned;
+    std::vector< Type > split;
+
+    if( !Interpp::ConvertValue( text, scanned ) || !ConvertByParamList( text, split ) || scanned != split )
+    {
+      Bench::Fail( typeName + " list of " + count + " did not convert" );
+    }
+
+    Bench::Report( "text -> std::vector< " + typeName + " > (" + count + "), from_chars",
+                   MegabytesPerSecond( Bench::NsPerOp( iterations, [&]( unsigned long )
+    {
+      Interpp::ConvertValue( text, scanned );
+      Bench::sink += scanned.size();
+    } ), text.size() ), "MB/s" );
+
+    Bench::Report( "text -> std::vector< " + typeName + " > (" + count + "), _ParamList",
+                   MegabytesPerSecond( Bench::NsPerOp( iterations, [&]( unsigned long )
+    {
+      ConvertByParamList( text, split );
+      Bench::sink += split.size();
+    } ), text.size() ), "MB/s" );
+  }
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Weights, SetWeights, unsigned long, const std::vector< double >& )
+
+//=================================================================================================
+
+void Bench::ListBench()
+{
+  BenchList< int >( "int", 16, -500, 7 );
+  BenchList< int >( "int", 4096, -500, 7 );
+  BenchList< double >( "double", 16, -1.5, 0.125 );
+  BenchList< double >( "double", 4096, -1.5, 0.125 );
+
+  // lists the direct parse rejects fall back to _ParamList, so their elements convert as params do
+  const char* lists[][2] =
+  {
+    { "[ ]", "[]" },
+    { "[+3 , -4,5]", "[3, -4, 5]" },
+    { "[1, '2']", "[1, 2]" },
+    { "[1,, 2]", "" },
+    { "[1, 2,]", "" },
+    { "[1 2]", "" },
+    { "[+-1]", "" }
+  };
+
+  for( const auto& list : lists )
+  {
+    std::vector< int > values;
+    bool converted = Interpp::ConvertValue( list[0], values );
+
+    if( converted != ( list[1][0] != '\0' ) || ( converted && Interpp::ConvertValue< std::string >( values ) != list[1] ) )
+    {
+      Fail( std::string( list[0] ) + " converted as " + ( converted ? Interpp::ConvertValue< std::string >( values ) : "invalid" ) );
+    }
+  }
+
+  Weights weights;
+  Interpp::RegisterObject( weights, "weights" );
+
+  std::string command = "weights.SetWeights( " + MakeList( 4096, 0.5, 0.25 ) + " )";
+
+  if( Interpp::Execute( command ) != "4096" )
+  {
+    Fail( "SetWeights returned " + Interpp::Execute( command ) );
+  }
+
+  Report( "Execute, SetWeights (4096 doubles)", NsPerOp( 2000, [&]( unsigned long )
+  {
+    sink += Interpp::Execute( command ).size();
+  } ) );
+}
+
+//=================================================================================================
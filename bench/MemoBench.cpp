@@ -0,0 +1,173 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+//=================================================================================================
+
+namespace
+{
+  class Pricing
+  {
+  public:
+    // a pure but non-trivial computation, registered both with and without memoization
+    double Quote( int units, double rate )
+    {
+      double quote = 0;
+
+      for( int i = 0; i < 200; ++i )
+      {
+        quote += units * rate / ( i + 1 );
+      }
+
+      return quote;
+    }
+
+    double QuotePure( int units, double rate )
+    {
+      return Quote( units, rate );
+    }
+
+    // a result too long for the short string buffer, so that copying it allocates
+    std::string Describe( int units )
+    {
+      return "a quote for " + std::to_string( units ) + " units at the standard rate";
+    }
+
+    std::string Echo( std::string text )
+    {
+      return text;
+    }
+  };
+
+  // fails unless the last NsPerOp() made no heap allocations
+  void CheckNoAllocations( const std::string& name )
+  {
+    if( Bench::allocsPerOp != 0 )
+    {
+      Bench::Fail( name + " made " + std::to_string( Bench::allocsPerOp ) + " heap allocations per op" );
+    }
+  }
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Pricing, Quote, double, int, double )
+INTERPP_REGISTER_METHOD_RETURN_PURE( Pricing, QuotePure, double, int, double )
+INTERPP_REGISTER_METHOD_RETURN_PURE( Pricing, Describe, std::string, int )
+INTERPP_REGISTER_METHOD_RETURN_PURE( Pricing, Echo, std::string, std::string )
+
+//=================================================================================================
+
+void Bench::MemoBench()
+{
+  const unsigned long iterations = 500000;
+  const unsigned long distinctArgs = 64;
+
+  Pricing pricing;
+  Interpp::RegisterObject( pricing, "pricing" );
+
+  std::string quote[distinctArgs];
+  std::string quotePure[distinctArgs];
+
+  for( unsigned long i = 0; i < distinctArgs; ++i )
+  {
+    quote[i] = "pricing.Quote( " + std::to_string( i ) + ", 1.25 )";
+    quotePure[i] = "pricing.QuotePure( " + std::to_string( i ) + ", 1.25 )";
+
+    if( Interpp::Execute( quote[i] ) != Interpp::Execute( quotePure[i] ) )
+    {
+      Fail( "memoized Quote differs for " + std::to_string( i ) + " units" );
+    }
+  }
+
+  Report( "Execute, not memoized", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += Interpp::Execute( quote[i % distinctArgs] ).size();
+  } ) );
+
+  Interpp::MemoStats before = Interpp::GetMemoStats();
+
+  Report( "Execute, Pure (memoized)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += Interpp::Execute( quotePure[i % distinctArgs] ).size();
+  } ) );
+
+  Interpp::TypedMethod typedQuote = Interpp::Resolve( "pricing", "Quote" );
+  Interpp::TypedMethod typedQuotePure = Interpp::Resolve( "pricing", "QuotePure" );
+
+  Report( "TypedMethod::Invoke, not memoized", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += typedQuote.Invoke( { ( int ) ( i % distinctArgs ), 1.25 } ).AsReal() > 0;
+  } ) );
+
+  Report( "TypedMethod::Invoke, Pure (memoized)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += typedQuotePure.Invoke( { ( int ) ( i % distinctArgs ), 1.25 } ).AsReal() > 0;
+  } ) );
+
+  Interpp::MemoStats after = Interpp::GetMemoStats();
+  unsigned long long hits = after.hits - before.hits;
+  unsigned long long misses = after.misses - before.misses;
+
+  Report( "memo hit rate", 100.0 * hits / ( hits + misses ), "%" );
+
+  if( hits + misses != 2 * iterations )
+  {
+    Fail( "memo stats do not account for every Pure call" );
+  }
+
+  // hits on a long text result, into a result reused across calls
+  std::string describe[distinctArgs];
+  std::string result;
+  Interpp::Value typedResult;
+  Interpp::TypedMethod typedDescribe = Interpp::Resolve( "pricing", "Describe" );
+
+  for( unsigned long i = 0; i < distinctArgs; ++i )
+  {
+    describe[i] = "pricing.Describe( " + std::to_string( i ) + " )";
+    result.clear();
+
+    if( Interpp::Execute( describe[i], result ) != Interpp::ExecuteOk || result != pricing.Describe( ( int ) i ) )
+    {
+      Fail( "memoized Describe differs for " + std::to_string( i ) + " units" );
+    }
+
+    Interpp::Value units( ( int ) i );
+    typedDescribe.Invoke( &units, 1, typedResult );
+  }
+
+  Report( "Execute into a reused result, Pure text hit", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    result.clear();
+    Interpp::Execute( describe[i % distinctArgs], result );
+    sink += result.size();
+  } ) );
+
+  CheckNoAllocations( "a Pure text hit" );
+
+  Report( "TypedMethod::Invoke into a reused Value, Pure text hit", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    Interpp::Value units( ( int ) ( i % distinctArgs ) );
+    typedDescribe.Invoke( &units, 1, typedResult );
+    sink += typedResult.AsString().size();
+  } ) );
+
+  CheckNoAllocations( "a typed Pure text hit" );
+
+  // params that read the same but convert differently must not share a result
+  const char* echoes[][2] =
+  {
+    { "pricing.Echo( 'a\\'b' )", "a'b" },
+    { "pricing.Echo( a\\'b )", "a\\'b" },
+    { "pricing.Echo( 'x' )", "x" },
+    { "pricing.Echo( x )", "x" }
+  };
+
+  for( const auto& echo : echoes )
+  {
+    if( Interpp::Execute( echo[0] ) != echo[1] )
+    {
+      Fail( std::string( echo[0] ) + " gave " + Interpp::Execute( echo[0] ) + ", not " + echo[1] );
+    }
+  }
+}
+
+//=================================================================================================
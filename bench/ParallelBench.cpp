@@ -0,0 +1,190 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  // a first base, so that an Accumulator's Sequence lies at an offset within it
+  class Ledger
+  {
+  public:
+    long long balance = 0;
+  };
+
+  // Calls numbered n = 0, 1, 2, ... must arrive in order for each object, whether through the
+  // object's own Step() or the inherited Skip(), which is called on its Sequence
+  class Sequence
+  {
+  public:
+    long Skip( int step )
+    {
+      Next( step );
+      return step;
+    }
+
+    bool InOrder() const
+    {
+      return _inOrder;
+    }
+
+  protected:
+    void Next( int step )
+    {
+      _inOrder &= step == _steps++;
+    }
+
+    int _steps = 0;
+    bool _inOrder = true;
+  };
+
+  // Step( n ) does a little work per call
+  class Accumulator : public Ledger, public Sequence
+  {
+  public:
+    long Step( int step, int work )
+    {
+      Next( step );
+
+      for( int i = 0; i < work; ++i )
+      {
+        _state = _state * 6364136223846793005ULL + 1442695040888963407ULL;
+      }
+
+      return ( long ) ( _state >> 40 );
+    }
+
+    void Reset()
+    {
+      _state = 0;
+      _steps = 0;
+      _inOrder = true;
+    }
+
+  private:
+    unsigned long long _state = 0;
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Accumulator, Step, long, int, int )
+INTERPP_REGISTER_METHOD_RETURN( Sequence, Skip, long, int )
+INTERPP_REGISTER_BASE( Accumulator, Sequence )
+
+//=================================================================================================
+
+void Bench::ParallelBench()
+{
+  const unsigned long objectCount = 256;
+  const unsigned long commandCount = 32768;
+  const unsigned long rounds = 10;
+  const int work = 200;
+
+  std::vector< Accumulator > accumulators( objectCount );
+
+  for( unsigned long i = 0; i < objectCount; ++i )
+  {
+    Interpp::RegisterObject( accumulators[i], "acc" + std::to_string( i ) );
+  }
+
+  // objects interleaved, so each object's steps are spread through the batch; every eighth step
+  // goes through the inherited Skip()
+  std::vector< std::string > commands;
+
+  for( unsigned long i = 0; i < commandCount; ++i )
+  {
+    std::string object = "acc" + std::to_string( i % objectCount );
+    std::string step = std::to_string( i / objectCount );
+
+    commands.push_back( ( i / objectCount ) % 8 == 7 ? object + ".Skip( " + step + " )" :
+                                                        object + ".Step( " + step + ", " + std::to_string( work ) + " )" );
+  }
+
+  Interpp::BatchResults expected;
+  Interpp::BatchResults results;
+
+  Interpp::ExecuteBatch( commands.data(), commandCount, expected );
+
+  // at least 4, so that the order of calls is checked across threads even on a single core
+  unsigned int maxThreads = std::max( std::thread::hardware_concurrency(), 4u );
+
+  for( unsigned int threads = 1; threads <= maxThreads; threads *= 2 )
+  {
+    Interpp::ParallelExecutor executor( threads );
+
+    double ns = NsPerOp( rounds, [&]( unsigned long )
+    {
+      for( unsigned long i = 0; i < objectCount; ++i )
+      {
+        accumulators[i].Reset();
+      }
+
+      executor.ExecuteBatch( commands.data(), commandCount, results );
+    } );
+
+    for( unsigned long i = 0; i < objectCount; ++i )
+    {
+      if( !accumulators[i].InOrder() )
+      {
+        Fail( "calls on acc" + std::to_string( i ) + " ran out of order with " + std::to_string( threads ) + " threads" );
+        break;
+      }
+    }
+
+    if( results.Text() != expected.Text() || results.Offsets() != expected.Offsets() )
+    {
+      Fail( "ParallelExecutor results differ from ExecuteBatch with " + std::to_string( threads ) + " threads" );
+    }
+
+    Report( "ParallelExecutor, " + std::to_string( threads ) + " thread(s), per command", PerItem( ns, commandCount ) );
+  }
+
+  for( unsigned long i = 0; i < objectCount; ++i )
+  {
+    accumulators[i].Reset();
+  }
+
+  Report( "ExecuteBatch (serial), per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    for( unsigned long i = 0; i < objectCount; ++i )
+    {
+      accumulators[i].Reset();
+    }
+
+    Interpp::ExecuteBatch( commands.data(), commandCount, results );
+  } ), commandCount ) );
+
+  // every command on one object: a single group, which the executor runs on the calling thread
+  const unsigned long singleCount = commandCount / 8;
+  std::vector< std::string > single;
+
+  for( unsigned long i = 0; i < singleCount; ++i )
+  {
+    single.push_back( i % 8 == 7 ? "acc0.Skip( " + std::to_string( i ) + " )" :
+                                   "acc0.Step( " + std::to_string( i ) + ", " + std::to_string( work ) + " )" );
+  }
+
+  accumulators[0].Reset();
+  Interpp::ExecuteBatch( single.data(), singleCount, expected );
+
+  Interpp::ParallelExecutor executor( maxThreads );
+
+  double ns = NsPerOp( rounds, [&]( unsigned long )
+  {
+    accumulators[0].Reset();
+    executor.ExecuteBatch( single.data(), singleCount, results );
+  } );
+
+  Report( "ParallelExecutor, " + std::to_string( maxThreads ) + " threads, one object, per command", PerItem( ns, singleCount ) );
+
+  if( !accumulators[0].InOrder() || results.Text() != expected.Text() || results.Offsets() != expected.Offsets() )
+  {
+    Fail( "ParallelExecutor differs from ExecuteBatch on a single object" );
+  }
+}
+
+//=================================================================================================
@@ -0,0 +1,59 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+#include <iostream>
+
+//=================================================================================================
+
+namespace
+{
+  class Sensor
+  {
+  public:
+    float Scale( float reading, float factor )
+    {
+      return reading * factor;
+    }
+
+    void Calibrate( int offset )
+    {
+      _offset = offset;
+    }
+
+  private:
+    int _offset = 0;
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Sensor, Scale, float, float, float )
+INTERPP_REGISTER_METHOD_VOID( Sensor, Calibrate, int )
+
+//=================================================================================================
+
+// Execute cost with the profiling hooks as built; with INTERPP_PROFILING on, also dumps the profile
+void Bench::ProfileBench()
+{
+  const unsigned long iterations = 1000000;
+
+  Sensor sensor;
+  Interpp::RegisterObject( sensor, "sensor" );
+  Interpp::ResetProfile();
+
+  Report( std::string( "Execute, profiling " ) + ( INTERPP_PROFILING ? "on" : "off" ), NsPerOp( iterations, []( unsigned long i )
+  {
+    sink += Interpp::Execute( i % 4 == 0 ? "sensor.Calibrate( 3 )" : "sensor.Scale( 1.5, 2 )" ).size();
+  } ) );
+
+  Report( "TypedMethod::Invoke", NsPerOp( iterations, [scale = Interpp::Resolve( "sensor", "Scale" )]( unsigned long )
+  {
+    sink += scale.Invoke( { 1.5f, 2.0f } ).AsReal() > 0;
+  } ) );
+
+  if( INTERPP_PROFILING )
+  {
+    std::cout << Interpp::DumpProfile() << Interpp::DumpProfileJson() << '\n';
+  }
+}
+
+//=================================================================================================
@@ -0,0 +1,288 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <map>
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  const int typeCount = 10;
+  const int methodsPerType = 1000;
+  const unsigned long iterations = 2000000;
+
+  template< int N >
+  struct BenchType
+  {
+  };
+
+  bool DummyCall( void*, const Interpp::_ParamList&, std::string& )
+  {
+    return true;
+  }
+
+  Interpp::_PreparedCall* DummyPrepare( void*, const Interpp::_ParamList& )
+  {
+    return NULL;
+  }
+
+  std::string MethodName( int i )
+  {
+    return "Method" + std::to_string( i );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // The std::map registry Interpp used before the flat hash table, kept here for comparison
+  class LegacyRegistry
+  {
+  public:
+    template< class ObjectType >
+    void AddObject( void* object, const std::string& objectName )
+    {
+      _objects[ objectName ] = std::make_pair( std::string( typeid( ObjectType ).name() ), object );
+    }
+
+    template< class ObjectType >
+    void AddMethod( Interpp::_interppMethod method, std::string methodName )
+    {
+      methodName += typeid( ObjectType ).name();
+      _methods[ methodName ] = method;
+    }
+
+    Interpp::_interppMethod GetMethod( std::string& objectName, std::string& methodName )
+    {
+      std::map< std::string, std::pair< std::string, void* > >::const_iterator objectIt = _objects.find( objectName );
+
+      if( objectIt == _objects.end() )
+      {
+        return NULL;
+      }
+
+      methodName += objectIt->second.first;
+      std::map< std::string, Interpp::_interppMethod >::const_iterator methodIt = _methods.find( methodName );
+
+      if( methodIt == _methods.end() )
+      {
+        return NULL;
+      }
+
+      return methodIt->second;
+    }
+
+  private:
+    std::map< std::string, std::pair< std::string, void* > > _objects;
+    std::map< std::string, Interpp::_interppMethod > _methods;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< int N >
+  void RegisterType( LegacyRegistry& legacy, std::vector< Interpp::ObjectHandle >& handles, BenchType< N >& object )
+  {
+    std::string objectName = "object" + std::to_string( N );
+
+    handles.push_back( Interpp::RegisterObject( object, objectName ) );
+    legacy.AddObject< BenchType< N > >( &object, objectName );
+
+    for( int i = 0; i < methodsPerType; ++i )
+    {
+      Interpp::_InterppMethodInfo methodInfo = { DummyCall, DummyPrepare, NULL, 0 };
+      Interpp::_InterppRegistry::AddMethod< BenchType< N > >( methodInfo, MethodName( i ) );
+      legacy.AddMethod< BenchType< N > >( DummyCall, MethodName( i ) );
+    }
+  }
+
+  template< int... Ns >
+  void RegisterTypes( LegacyRegistry& legacy, std::vector< Interpp::ObjectHandle >& handles, std::integer_sequence< int, Ns... > )
+  {
+    static std::tuple< BenchType< Ns >... > objects;
+    ( void ) std::initializer_list< int >{ ( RegisterType( legacy, handles, std::get< Ns >( objects ) ), 0 )... };
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // registering methods one at a time, against method nodes taken in by the next lookup
+  void BenchRegistration()
+  {
+    const unsigned long methodCount = 1000;
+
+    static BenchType< typeCount > added;
+    static BenchType< typeCount + 1 > declared;
+    Interpp::RegisterObject( added, "added" );
+    Interpp::RegisterObject( declared, "declared" );
+
+    // nodes and their names must outlive the registry's references to them
+    static std::vector< std::string > names;
+    static std::vector< Interpp::_MethodNode > nodes;
+    names.reserve( methodCount );
+    nodes.reserve( methodCount );
+
+    for( unsigned long i = 0; i < methodCount; ++i )
+    {
+      names.push_back( "Static" + std::to_string( i ) );
+    }
+
+    Interpp::_InterppMethodInfo methodInfo = { DummyCall, DummyPrepare, NULL, 0 };
+
+    Bench::Report( "register 1000 methods, AddMethod (per method)", Bench::PerItem( Bench::NsPerOp( 1, [&]( unsigned long )
+    {
+      for( unsigned long i = 0; i < methodCount; ++i )
+      {
+        Interpp::_InterppRegistry::AddMethod< BenchType< typeCount > >( methodInfo, names[i] );
+      }
+    } ), methodCount ) );
+
+    Bench::Report( "register 1000 methods, method nodes (per method)", Bench::PerItem( Bench::NsPerOp( 1, [&]( unsigned long )
+    {
+      for( unsigned long i = 0; i < methodCount; ++i )
+      {
+        nodes.emplace_back( typeid( BenchType< typeCount + 1 > ), names[i].c_str(), Interpp::_ConstHashName( names[i].c_str() ), methodInfo );
+        Interpp::_RegisterMethodNode( &nodes.back() );
+      }
+
+      Bench::sink += Interpp::_InterppRegistry::GetMethod( "declared", names[0] ).call != NULL;
+    } ), methodCount ) );
+
+    for( unsigned long i = 0; i < methodCount; ++i )
+    {
+      if( Interpp::_InterppRegistry::GetMethod( "declared", names[i] ).call == NULL )
+      {
+        Bench::Fail( "method node " + names[i] + " was not registered" );
+        break;
+      }
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // registering and unregistering objects over and over, which should keep reusing the same slots
+  void BenchUnregistration()
+  {
+    const unsigned long objectCount = 100;
+    const unsigned long rounds = 20;
+
+    static BenchType< typeCount + 2 > objects[objectCount];
+    std::vector< std::string > names;
+    std::vector< Interpp::ObjectHandle > handles( objectCount );
+
+    for( unsigned long i = 0; i < objectCount; ++i )
+    {
+      names.push_back( "transient" + std::to_string( i ) );
+    }
+
+    Interpp::ObjectHandle firstHandle = 0;
+
+    Bench::Report( "register + unregister 100 objects (per object)", Bench::PerItem( Bench::NsPerOp( rounds, [&]( unsigned long round )
+    {
+      Interpp::RegistrationBatch batch;
+
+      for( unsigned long i = 0; i < objectCount; ++i )
+      {
+        handles[i] = Interpp::RegisterObject( objects[i], names[i] );
+      }
+
+      if( round == 0 )
+      {
+        firstHandle = handles[0];
+      }
+
+      for( unsigned long i = 0; i < objectCount; ++i )
+      {
+        Interpp::UnregisterObject( handles[i] );
+      }
+    } ), rounds * objectCount ) );
+
+    Interpp::ObjectHandle handle = Interpp::RegisterObject( objects[0], names[0] );
+
+    if( ( handle & 0xffffffffULL ) != ( firstHandle & 0xffffffffULL ) || handle == firstHandle )
+    {
+      Bench::Fail( "unregistered object slots were not reused" );
+    }
+
+    if( Interpp::_InterppRegistry::GetObject( firstHandle ) != NULL ||
+        Interpp::_InterppRegistry::GetObject( "#" + std::to_string( firstHandle ) ) != NULL )
+    {
+      Bench::Fail( "a stale handle still finds an object" );
+    }
+
+    Interpp::UnregisterObject( handle );
+  }
+}
+
+//=================================================================================================
+
+void Bench::RegistryBench()
+{
+  LegacyRegistry legacy;
+  std::vector< Interpp::ObjectHandle > handles;
+  RegisterTypes( legacy, handles, std::make_integer_sequence< int, typeCount >() );
+
+  // pseudo-random lookup sequence so that successive lookups do not hit the same cache lines
+  std::vector< std::string > objectNames;
+  std::vector< Interpp::ObjectHandle > objectHandles;
+  std::vector< std::string > handleNames;
+  std::vector< std::string > methodNames;
+
+  for( unsigned long i = 0, x = 1; i < 4096; ++i )
+  {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    unsigned long type = ( x >> 33 ) % typeCount;
+    objectNames.push_back( "object" + std::to_string( type ) );
+    objectHandles.push_back( handles[type] );
+    handleNames.push_back( "#" + std::to_string( handles[type] ) );
+    methodNames.push_back( MethodName( ( x >> 17 ) % methodsPerType ) );
+  }
+
+  Report( "GetMethod, flat hash (10k methods)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += Interpp::_InterppRegistry::GetMethod( objectNames[i & 4095], methodNames[i & 4095] ).call != NULL;
+  } ) );
+
+  Report( "GetMethod by handle, flat hash (10k methods)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += Interpp::_InterppRegistry::GetMethod( objectHandles[i & 4095], methodNames[i & 4095] ).call != NULL;
+  } ) );
+
+  Report( "GetMethod by #handle, flat hash (10k methods)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += Interpp::_InterppRegistry::GetMethod( handleNames[i & 4095], methodNames[i & 4095] ).call != NULL;
+  } ) );
+
+  for( unsigned long i = 0; i < 4096; ++i )
+  {
+    if( Interpp::_InterppRegistry::GetMethod( handleNames[i], methodNames[i] ).call == NULL )
+    {
+      Fail( "no method found through " + handleNames[i] );
+      break;
+    }
+  }
+
+  Report( "GetMethod, std::map (10k methods)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    // the legacy lookup appends to the method name, so it has to work on a copy
+    std::string objectName = objectNames[i & 4095];
+    std::string methodName = methodNames[i & 4095];
+    sink += legacy.GetMethod( objectName, methodName ) != NULL;
+  } ) );
+
+  std::string missingMethod = "NoSuchMethod";
+
+  Report( "GetMethod miss, flat hash (10k methods)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    sink += Interpp::_InterppRegistry::GetMethod( objectNames[i & 4095], missingMethod ).call != NULL;
+  } ) );
+
+  Report( "GetMethod miss, std::map (10k methods)", NsPerOp( iterations, [&]( unsigned long i )
+  {
+    std::string objectName = objectNames[i & 4095];
+    std::string methodName = missingMethod;
+    sink += legacy.GetMethod( objectName, methodName ) != NULL;
+  } ) );
+
+  BenchRegistration();
+  BenchUnregistration();
+}
+
+//=================================================================================================
@@ -0,0 +1,237 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+#include <vector>
+
+//=================================================================================================
+
+namespace
+{
+  // _ParamList as it was before lists holding brackets or quotes were walked through
+  // _FindStructure(), kept here for comparison: such a list is bounded a byte at a time.
+  class LegacyParamList
+  {
+  public:
+    explicit LegacyParamList( std::string_view params )
+      : _size( 0 )
+    {
+      if( params.size() == 0 )
+      {
+        return;
+      }
+
+      std::size_t commaPos = 0;
+      std::size_t paramStart = 0;
+      std::size_t paramEnd = 0;
+
+      while( commaPos != std::string_view::npos )
+      {
+        while( paramStart < params.size() - 1 && params[paramStart] == ' ' )
+        {
+          paramStart++;
+        }
+
+        commaPos = paramStart;
+
+        if( paramStart < params.size() && params[paramStart] == '\'' )
+        {
+          while( true )
+          {
+            commaPos = params.find( '\'', commaPos + 1 );
+
+            if( commaPos == std::string_view::npos || params[commaPos - 1] != '\\' )
+            {
+              break;
+            }
+          }
+        }
+        else if( paramStart < params.size() && params[paramStart] == '[' )
+        {
+          commaPos = ListEnd( params, paramStart );
+        }
+
+        commaPos = params.find( ',', commaPos );
+        paramEnd = commaPos != std::string_view::npos ? commaPos : params.size();
+
+        if( paramStart < paramEnd )
+        {
+          while( paramEnd > 0 && params[paramEnd - 1] == ' ' )
+          {
+            paramEnd--;
+          }
+        }
+        else
+        {
+          paramEnd = paramStart;
+        }
+
+        if( paramEnd - paramStart >= 2 &&
+            ( params[paramStart] == '\'' || params[paramStart] == '\"' ) &&
+            ( params[paramEnd-1] == '\'' || params[paramEnd-1] == '\"' ) )
+        {
+          paramStart++;
+          paramEnd--;
+        }
+
+        // the first 16 params are held inline, as in _ParamList
+        if( _size < 16 )
+        {
+          _inline[_size] = params.substr( paramStart, paramEnd - paramStart );
+        }
+        else
+        {
+          _overflow.push_back( params.substr( paramStart, paramEnd - paramStart ) );
+        }
+
+        _size++;
+        paramStart = commaPos + 1;
+      }
+    }
+
+    unsigned long Size() const
+    {
+      return _size;
+    }
+
+    std::string_view operator []( unsigned long i ) const
+    {
+      return i < 16 ? _inline[i] : _overflow[i - 16];
+    }
+
+  private:
+    static std::size_t ListEnd( std::string_view params, std::size_t start )
+    {
+      std::size_t close = params.find( ']', start + 1 );
+
+      if( close == std::string_view::npos )
+      {
+        return start;
+      }
+
+      std::string_view elements = params.substr( start + 1, close - start - 1 );
+
+      if( elements.find( '[' ) == std::string_view::npos &&
+          elements.find( '\'' ) == std::string_view::npos &&
+          elements.find( '\"' ) == std::string_view::npos )
+      {
+        return close;
+      }
+
+      unsigned long depth = 0;
+      char quote = '\0';
+
+      for( std::size_t i = start; i < params.size(); ++i )
+      {
+        if( quote != '\0' )
+        {
+          if( params[i] == quote && params[i - 1] != '\\' )
+          {
+            quote = '\0';
+          }
+        }
+        else if( params[i] == '\'' || params[i] == '\"' )
+        {
+          quote = params[i];
+        }
+        else if( params[i] == '[' )
+        {
+          depth++;
+        }
+        else if( params[i] == ']' && --depth == 0 )
+        {
+          return i;
+        }
+      }
+
+      return start;
+    }
+
+    std::string_view _inline[16];
+    std::vector< std::string_view > _overflow;
+    unsigned long _size;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // A machine-generated command of about size bytes: a few numbers and strings, then a table of
+  // rows, each a list of a number list and a string list
+  std::string MakeCommand( std::size_t size )
+  {
+    std::string command = "model.Load( 42, 0.5, 'table', [";
+
+    for( unsigned long i = 0; command.size() < size; ++i )
+    {
+      command += i == 0 ? "" : ", ";
+      command += "[[" + std::to_string( i ) + ", " + std::to_string( i * 0.25 ) + "], ['row " +
+                 std::to_string( i ) + "', 'note, with a comma']]";
+    }
+
+    command += "] )";
+    return command;
+  }
+
+  double MegabytesPerSecond( double nsPerOp, std::size_t bytes )
+  {
+    return bytes / nsPerOp * 1e9 / 1e6;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void BenchCommand( std::size_t size )
+  {
+    std::string command = MakeCommand( size );
+    std::string label = std::to_string( command.size() ) + " bytes";
+    unsigned long iterations = 20000000 / command.size() + 1;
+
+    std::string_view objectName;
+    std::string_view methodName;
+    std::string_view params;
+    Interpp::_SplitCommand( command, objectName, methodName, params );
+
+    Interpp::_ParamList paramList( params );
+    LegacyParamList legacyParamList( params );
+
+    if( paramList.Size() != 4 || legacyParamList.Size() != 4 || paramList[3] != legacyParamList[3] )
+    {
+      Bench::Fail( "params of " + label + " differ from the legacy split" );
+    }
+
+    Bench::Report( "split + params, scanned (" + label + ")", MegabytesPerSecond( Bench::NsPerOp( iterations, [&]( unsigned long )
+    {
+      Interpp::_SplitCommand( command, objectName, methodName, params );
+      Bench::sink += Interpp::_ParamList( params ).Size();
+    } ), command.size() ), "MB/s" );
+
+    Bench::Report( "split + params, byte by byte (" + label + ")", MegabytesPerSecond( Bench::NsPerOp( iterations, [&]( unsigned long )
+    {
+      Interpp::_SplitCommand( command, objectName, methodName, params );
+      Bench::sink += LegacyParamList( params ).Size();
+    } ), command.size() ), "MB/s" );
+
+    // the classifier alone, over the whole command
+    Bench::Report( "_FindStructure (" + label + ")", MegabytesPerSecond( Bench::NsPerOp( iterations, [&]( unsigned long )
+    {
+      unsigned int offsets[Interpp::_listChunk];
+      std::size_t position = 0;
+
+      while( position < command.size() )
+      {
+        unsigned long count;
+        Interpp::_FindStructure( command, position, offsets, Interpp::_listChunk, count );
+        Bench::sink += count;
+      }
+    } ), command.size() ), "MB/s" );
+  }
+}
+
+//=================================================================================================
+
+void Bench::ScanBench()
+{
+  BenchCommand( 100 );
+  BenchCommand( 1024 );
+  BenchCommand( 4096 );
+  BenchCommand( 65536 );
+}
+
+//=================================================================================================
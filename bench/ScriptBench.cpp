@@ -0,0 +1,73 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+//=================================================================================================
+
+namespace
+{
+  class Accumulate
+  {
+  public:
+    long long Add( long long total, int value )
+    {
+      return total + value;
+    }
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Accumulate, Add, long long, long long, int )
+
+//=================================================================================================
+
+void Bench::ScriptBench()
+{
+  const unsigned long steps = 1000;
+  const unsigned long rounds = 200;
+
+  Accumulate accumulate;
+  Interpp::RegisterObject( accumulate, "acc" );
+
+  // each step feeds the previous call's result into the next call
+  std::string total;
+
+  Report( "chained calls, Execute per step", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    total = "0";
+
+    for( unsigned long i = 0; i < steps; ++i )
+    {
+      total = Interpp::Execute( "acc.Add( " + total + ", " + std::to_string( i ) + " )" );
+    }
+  } ), steps ) );
+
+  Interpp::Script script = Interpp::CompileScript( "total = 0\n"
+                                                   "i = 0\n"
+                                                   "while i < steps\n"
+                                                   "{\n"
+                                                   "  total = acc.Add( total, i )\n"
+                                                   "  i = i + 1\n"
+                                                   "}\n"
+                                                   "total" );
+
+  if( !script.IsValid() )
+  {
+    Fail( "script failed to compile: " + script.GetError() );
+    return;
+  }
+
+  script.SetVariable( "steps", steps );
+  Interpp::Value result;
+
+  Report( "chained calls, Script loop per step", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    result = script.Run();
+  } ), steps ) );
+
+  if( total != result.ToString() )
+  {
+    Fail( "script result " + result.ToString() + " differs from Execute result " + total );
+  }
+}
+
+//=================================================================================================
@@ -0,0 +1,121 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+#include <cstdio>
+#include <sstream>
+
+//=================================================================================================
+
+namespace
+{
+  class Meter
+  {
+  public:
+    double Scale( double value, double factor )
+    {
+      return value * factor;
+    }
+
+    std::string Label( std::string name, int index )
+    {
+      return name + std::to_string( index );
+    }
+  };
+
+  // collects output, as a file or socket would, without the cost of a system call
+  class StringSink : public Interpp::StreamSink
+  {
+  public:
+    bool Write( const char* data, std::size_t size )
+    {
+      text.append( data, size );
+      return true;
+    }
+
+    std::string text;
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Meter, Scale, double, double, double )
+INTERPP_REGISTER_METHOD_RETURN( Meter, Label, std::string, std::string, int )
+
+//=================================================================================================
+
+void Bench::StreamBench()
+{
+  const unsigned long commandCount = 20000;
+  const unsigned long rounds = 10;
+  const char* path = "interpp_stream_bench.txt";
+
+  Meter meter;
+  Interpp::RegisterObject( meter, "meter" );
+
+  std::string commandLines;
+
+  for( unsigned long i = 0; i < commandCount; ++i )
+  {
+    commandLines += i % 2 == 0 ? "meter.Scale( " + std::to_string( i ) + ".5, 0.25 )\n" : "meter.Label( 'channel ', " + std::to_string( i ) + " )\n";
+  }
+
+  FILE* file = std::fopen( path, "wb" );
+
+  if( file == NULL || std::fwrite( commandLines.data(), 1, commandLines.size(), file ) != commandLines.size() )
+  {
+    Fail( "could not write " + std::string( path ) );
+  }
+
+  if( file != NULL )
+  {
+    std::fclose( file );
+  }
+
+  // the getline() loop the example driver uses, for comparison: each line is copied into a string
+  std::string expected;
+
+  Report( "getline + Execute, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    std::istringstream input( commandLines );
+    std::string command;
+    expected.clear();
+
+    while( std::getline( input, command ) )
+    {
+      expected += Interpp::Execute( command );
+      expected += '\n';
+    }
+  } ), commandCount ) );
+
+  StringSink output;
+  Interpp::StreamRunner runner( output );
+
+  Report( "StreamRunner, in memory, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    output.text.clear();
+    runner.Run( commandLines );
+  } ), commandCount ) );
+
+  if( output.text != expected )
+  {
+    Fail( "StreamRunner output differs from Execute" );
+  }
+
+  Report( "StreamRunner, mapped file, per command", PerItem( NsPerOp( rounds, [&]( unsigned long )
+  {
+    output.text.clear();
+
+    if( !runner.RunFile( path ) )
+    {
+      Fail( "StreamRunner could not run " + std::string( path ) );
+    }
+  } ), commandCount ) );
+
+  if( output.text != expected )
+  {
+    Fail( "StreamRunner output for a mapped file differs from Execute" );
+  }
+
+  std::remove( path );
+}
+
+//=================================================================================================
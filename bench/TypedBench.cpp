@@ -0,0 +1,84 @@
+#include "Bench.h"
+
+#include <Interpp.h>
+
+//=================================================================================================
+
+namespace
+{
+  class Vector3
+  {
+  public:
+    float Dot( float x, float y, float z )
+    {
+      return _x * x + _y * y + _z * z;
+    }
+
+    void Set( float x, float y, float z )
+    {
+      _x = x;
+      _y = y;
+      _z = z;
+    }
+
+  private:
+    float _x = 1.0f;
+    float _y = 2.0f;
+    float _z = 3.0f;
+  };
+}
+
+INTERPP_REGISTER_METHOD_RETURN( Vector3, Dot, float, float, float, float )
+INTERPP_REGISTER_METHOD_VOID( Vector3, Set, float, float, float )
+
+//=================================================================================================
+
+void Bench::TypedBench()
+{
+  const unsigned long iterations = 2000000;
+
+  Vector3 vector;
+  Interpp::RegisterObject( vector, "vector" );
+
+  // the host has native floats: Execute() needs them formatted into a command first
+  float x = 0.5f;
+  float y = 1.25f;
+  float z = -2.0f;
+
+  Report( "Dot, Execute (formatting the command)", NsPerOp( iterations, [&]( unsigned long )
+  {
+    std::string command = "vector.Dot( " + Interpp::ConvertValue< std::string >( x ) + ", " +
+                          Interpp::ConvertValue< std::string >( y ) + ", " +
+                          Interpp::ConvertValue< std::string >( z ) + " )";
+    sink += Interpp::ConvertValue< float >( Interpp::Execute( command ) ) > 0;
+  } ) );
+
+  Report( "Dot, Invoke by name", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += Interpp::Invoke( "vector", "Dot", { x, y, z } ).AsReal() > 0;
+  } ) );
+
+  Interpp::TypedMethod dot = Interpp::Resolve( "vector", "Dot" );
+
+  Report( "Dot, resolved TypedMethod::Invoke", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += dot.Invoke( { x, y, z } ).AsReal() > 0;
+  } ) );
+
+  Interpp::TypedMethod set = Interpp::Resolve( "vector", "Set" );
+
+  Report( "Set, Execute (formatting the command)", NsPerOp( iterations, [&]( unsigned long )
+  {
+    std::string command = "vector.Set( " + Interpp::ConvertValue< std::string >( x ) + ", " +
+                          Interpp::ConvertValue< std::string >( y ) + ", " +
+                          Interpp::ConvertValue< std::string >( z ) + " )";
+    sink += Interpp::Execute( command ).size();
+  } ) );
+
+  Report( "Set, resolved TypedMethod::Invoke", NsPerOp( iterations, [&]( unsigned long )
+  {
+    sink += set.Invoke( { x, y, z } ).IsVoid();
+  } ) );
+}
+
+//=================================================================================================
@@ -0,0 +1,163 @@
+#include "Bench.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+//=================================================================================================
+
+static thread_local unsigned long long allocations = 0;
+
+// counting replacements for the global allocation functions (the array and nothrow forms call these)
+void* operator new( std::size_t size )
+{
+  ++allocations;
+
+  if( void* memory = malloc( size ? size : 1 ) )
+  {
+    return memory;
+  }
+
+  throw std::bad_alloc();
+}
+
+void* operator new( std::size_t size, std::align_val_t alignment )
+{
+  ++allocations;
+
+  // aligned_alloc needs a size that is a multiple of the alignment
+  std::size_t align = ( std::size_t ) alignment;
+
+  if( void* memory = aligned_alloc( align, ( size + align - 1 ) / align * align ) )
+  {
+    return memory;
+  }
+
+  throw std::bad_alloc();
+}
+
+void operator delete( void* memory ) noexcept
+{
+  free( memory );
+}
+
+void operator delete( void* memory, std::size_t ) noexcept
+{
+  free( memory );
+}
+
+void operator delete( void* memory, std::align_val_t ) noexcept
+{
+  free( memory );
+}
+
+void operator delete( void* memory, std::size_t, std::align_val_t ) noexcept
+{
+  free( memory );
+}
+
+//=================================================================================================
+
+namespace Bench
+{
+  volatile unsigned long sink = 0;
+  thread_local double allocsPerOp = 0;
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned long long Allocations()
+  {
+    return allocations;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void Report( const std::string& name, double value, const char* unit )
+  {
+    std::cout << std::left << std::setw( 56 ) << name
+              << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 ) << value << " " << unit;
+
+    if( strcmp( unit, "ns/op" ) == 0 )
+    {
+      std::cout << std::setw( 10 ) << std::setprecision( 2 ) << allocsPerOp << " allocs/op";
+    }
+
+    std::cout << '\n';
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  static bool failed = false;
+
+  void Fail( const std::string& message )
+  {
+    std::cout << "FAILED: " << message << '\n';
+    failed = true;
+  }
+
+  bool Failed()
+  {
+    return failed;
+  }
+}
+
+//=================================================================================================
+
+struct BenchGroup
+{
+  const char* name;
+  void ( *run )();
+};
+
+static const BenchGroup benchGroups[] =
+{
+  { "registry", Bench::RegistryBench },
+  { "concurrency", Bench::ConcurrencyBench },
+  { "convert", Bench::ConvertBench },
+  { "typed", Bench::TypedBench },
+  { "batch", Bench::BatchBench },
+  { "parallel", Bench::ParallelBench },
+  { "script", Bench::ScriptBench },
+  { "async", Bench::AsyncBench },
+  { "memo", Bench::MemoBench },
+  { "profile", Bench::ProfileBench },
+  { "callpath", Bench::CallPathBench },
+  { "list", Bench::ListBench },
+  { "scan", Bench::ScanBench },
+  { "stream", Bench::StreamBench },
+  { "dispatch", Bench::DispatchBench },
+  { "field", Bench::FieldBench },
+  { "broadcast", Bench::BroadcastBench },
+  { "interpreter", Bench::InterpreterBench },
+  { "bytecode", Bench::BytecodeBench },
+};
+
+//-------------------------------------------------------------------------------------------------
+
+// Usage: interpp_bench [group...]
+// Runs every benchmark group if none are named.
+int main( int argc, char* argv[] )
+{
+  for( unsigned long i = 0; i < sizeof( benchGroups ) / sizeof( benchGroups[0] ); ++i )
+  {
+    bool selected = argc == 1;
+
+    for( int arg = 1; arg < argc; ++arg )
+    {
+      selected |= strcmp( argv[arg], benchGroups[i].name ) == 0;
+    }
+
+    if( selected )
+    {
+      std::cout << "[" << benchGroups[i].name << "]\n";
+      benchGroups[i].run();
+      std::cout << '\n';
+    }
+  }
+
+  return Bench::Failed() ? 1 : 0;
+}
+
+//=================================================================================================
@@ -55,23 +55,28 @@ INTERPP_REGISTER_METHOD_VOID( Simple, Print, std::string, bool )
 INTERPP_REGISTER_METHOD_RETURN( Simple, Multiply, float, float, float )
 INTERPP_REGISTER_METHOD_VOID( Simple, Who )
 
+// Simple2 answers Simple's methods
+INTERPP_REGISTER_BASE( Simple2, Simple )
+
 //=================================================================================================
 
-int main()
+int main( int argc, char* argv[] )
 {
-  // Init Methods
-  // ============
-  Interpp::Init_Simple_SameNumber();
-  Interpp::Init_Simple_Print();
-  Interpp::Init_Simple_Multiply();
-  Interpp::Init_Simple_Who();
-
   // Expose Class Instances To Interpp
   // =================================
   Simple simple;
   Simple2 simple2;
   Interpp::RegisterObject( simple, "simple" );
-  Interpp::RegisterObject( (Simple&)simple2, "simple2" );
+  Interpp::RegisterObject( simple2, "simple2" );
+
+  // Run A Command File, One Command Per Line
+  // ========================================
+  if( argc > 1 )
+  {
+    Interpp::FdSink output( 1 );
+    Interpp::StreamRunner runner( output );
+    return runner.RunFile( argv[1] ) ? 0 : 1;
+  }
 
   // Run Interactive Interpretor
   // ===========================
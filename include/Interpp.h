@@ -35,152 +35,593 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 #include <vector>
 #include <map>
-#include <sstream>
 #include <typeinfo>
 #include <cstdlib>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <deque>
+#include <string_view>
+#include <charconv>
+#include <system_error>
+#include <limits>
+#include <memory_resource>
+#include <initializer_list>
+#include <functional>
+#include <future>
+#include <exception>
+#include <chrono>
+
+#if defined( __cpp_impl_coroutine ) && __has_include( <coroutine> )
+#include <coroutine>
+#endif
 
 //=================================================================================================
 
-#define _INTERPP_REGISTER_METHOD_RETURN( Class, Method, ReturnType, ... )\
+// Build with INTERPP_PROFILING=1 (the CMake option of the same name) to record per-method call
+// counts and phase timings; see Interpp::DumpProfile()
+#ifndef INTERPP_PROFILING
+#define INTERPP_PROFILING 0
+#endif
+
+//=================================================================================================
+
+#define _INTERPP_REGISTER_METHOD_RETURN( Class, Method, Flags, ReturnType, ... )\
 namespace Interpp\
 {\
-  static std::string _Call_##Class##_##Method( std::string& objectName, std::string& params )\
+  static bool _Call_##Class##_##Method( void* object, const _ParamList& params, std::string& result )\
+  {\
+    ReturnType ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
+    return _Call_Method< Class, ReturnType, ##__VA_ARGS__ >( ( Class* ) object, methPtr, params, result, #Class "::" #Method );\
+  }\
+\
+  static _PreparedCall* _Prepare_##Class##_##Method( void* object, const _ParamList& params )\
   {\
-    Class* object = ( Class* ) ( _InterppRegistry::GetObject( objectName ) );\
-    if( object )\
-    {\
-      ReturnType ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
-      return ConvertValue< std::string >( _Call_Method< Class, ReturnType, ##__VA_ARGS__ >( object, methPtr, params ) );\
-    }\
-    else\
-    {\
-      return "Error: object not found";\
-    }\
+    ReturnType ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
+    return _Prepare_Method< Class, ReturnType, ##__VA_ARGS__ >( ( Class* ) object, methPtr, params );\
   }\
 \
-  static void Init_##Class##_##Method()\
+  static void _Invoke_##Class##_##Method( void* object, const Value* args, unsigned long argCount, Value& result )\
   {\
-    _InterppRegistry::AddMethod< Class >( _Call_##Class##_##Method, #Method );\
+    ReturnType ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
+    _Invoke_Method< Class, ReturnType, ##__VA_ARGS__ >( ( Class* ) object, methPtr, args, argCount, result, #Class "::" #Method );\
   }\
+\
+  static _MethodNode _Node_##Class##_##Method( typeid( Class ), #Method, _ConstHashName( #Method ),\
+    { _Call_##Class##_##Method, _Prepare_##Class##_##Method, _Invoke_##Class##_##Method, Flags } );\
+  [[maybe_unused]] static const bool _Registered_##Class##_##Method = _RegisterMethodNode( &_Node_##Class##_##Method );\
+\
+  /* methods register themselves; kept so that existing Init_ calls still compile */\
+  static inline void Init_##Class##_##Method() {}\
 }
 
 //-------------------------------------------------------------------------------------------------
 
-#define _INTERPP_REGISTER_METHOD_VOID( Class, Method, ... )\
+#define _INTERPP_REGISTER_METHOD_VOID( Class, Method, Flags, ... )\
 namespace Interpp\
 {\
-  static std::string _Call_##Class##_##Method( std::string& objectName, std::string& params )\
+  static bool _Call_##Class##_##Method( void* object, const _ParamList& params, std::string& result )\
   {\
-    Class* object = ( Class* ) ( _InterppRegistry::GetObject( objectName ) );\
-    if( object )\
-    {\
-      void ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
-      _Call_Method< Class, void, ##__VA_ARGS__ >( object, methPtr, params );\
-      return "";\
-    }\
-    else\
-    {\
-      return "Error: object not found";\
-    }\
+    void ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
+    return _Call_Method< Class, void, ##__VA_ARGS__ >( ( Class* ) object, methPtr, params, result, #Class "::" #Method );\
   }\
 \
-  static void Init_##Class##_##Method()\
+  static _PreparedCall* _Prepare_##Class##_##Method( void* object, const _ParamList& params )\
   {\
-    _InterppRegistry::AddMethod< Class >( _Call_##Class##_##Method, #Method );\
+    void ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
+    return _Prepare_Method< Class, void, ##__VA_ARGS__ >( ( Class* ) object, methPtr, params );\
   }\
+\
+  static void _Invoke_##Class##_##Method( void* object, const Value* args, unsigned long argCount, Value& result )\
+  {\
+    void ( Class::*methPtr )( __VA_ARGS__ ) = &Class::Method;\
+    _Invoke_Method< Class, void, ##__VA_ARGS__ >( ( Class* ) object, methPtr, args, argCount, result, #Class "::" #Method );\
+  }\
+\
+  static _MethodNode _Node_##Class##_##Method( typeid( Class ), #Method, _ConstHashName( #Method ),\
+    { _Call_##Class##_##Method, _Prepare_##Class##_##Method, _Invoke_##Class##_##Method, Flags } );\
+  [[maybe_unused]] static const bool _Registered_##Class##_##Method = _RegisterMethodNode( &_Node_##Class##_##Method );\
+\
+  /* methods register themselves; kept so that existing Init_ calls still compile */\
+  static inline void Init_##Class##_##Method() {}\
+}
+
+//-------------------------------------------------------------------------------------------------
+
+#define INTERPP_REGISTER_METHOD_RETURN( Class, Method, ReturnType, ... ) _INTERPP_REGISTER_METHOD_RETURN( Class, Method, 0, ReturnType, ##__VA_ARGS__ )
+#define INTERPP_REGISTER_METHOD_VOID( Class, Method, ... ) _INTERPP_REGISTER_METHOD_VOID( Class, Method, 0, ##__VA_ARGS__ )
+
+// as above, with MethodFlags (e.g. Interpp::LongRunning) combined with |
+#define INTERPP_REGISTER_METHOD_RETURN_FLAGS( Class, Method, Flags, ReturnType, ... ) _INTERPP_REGISTER_METHOD_RETURN( Class, Method, Flags, ReturnType, ##__VA_ARGS__ )
+#define INTERPP_REGISTER_METHOD_VOID_FLAGS( Class, Method, Flags, ... ) _INTERPP_REGISTER_METHOD_VOID( Class, Method, Flags, ##__VA_ARGS__ )
+
+#define INTERPP_REGISTER_METHOD_RETURN_PURE( Class, Method, ReturnType, ... ) _INTERPP_REGISTER_METHOD_RETURN( Class, Method, Interpp::Pure, ReturnType, ##__VA_ARGS__ )
+
+//-------------------------------------------------------------------------------------------------
+
+// Binds a data member, so that commands read it as object.Field and write it as object.Field = value
+// (or as object.Field() and object.Field( value )). Type is the member's declared type. object.*
+// reads every field registered for the object's class at once. Writes do not invalidate memoized
+// results, so call InvalidateMemo() after them as after any other change to the object.
+#define INTERPP_REGISTER_FIELD( Class, Field, Type )\
+namespace Interpp\
+{\
+  static _MethodNode _Node_##Class##_##Field( typeid( Class ), #Field, _ConstHashName( #Field ),\
+    { _Field< Class, Type, &Class::Field >::Call, _Field< Class, Type, &Class::Field >::Prepare,\
+      _Field< Class, Type, &Class::Field >::Invoke, 0 } );\
+  [[maybe_unused]] static const bool _Registered_##Class##_##Field = _RegisterMethodNode( &_Node_##Class##_##Field );\
+\
+  static _FieldNode _FieldNode_##Class##_##Field = { #Field, _Field< Class, Type, &Class::Field >::Append, NULL };\
+  [[maybe_unused]] static const bool _Listed_##Class##_##Field = _FieldList< Class >::Add( &_FieldNode_##Class##_##Field );\
 }
 
 //-------------------------------------------------------------------------------------------------
 
-#define INTERPP_REGISTER_METHOD_RETURN( Class, Method, ReturnType, ... ) _INTERPP_REGISTER_METHOD_RETURN( Class, Method, ReturnType, ##__VA_ARGS__ )
-#define INTERPP_REGISTER_METHOD_VOID( Class, Method, ... ) _INTERPP_REGISTER_METHOD_VOID( Class, Method, ##__VA_ARGS__ )
+// Lets objects registered as Class answer the methods registered for BaseClass (and its own bases),
+// e.g. INTERPP_REGISTER_BASE( Simple2, Simple ). Methods registered for Class itself come first,
+// then each base in the order registered. An inherited method runs on the object converted to
+// BaseClass*, which is also the pointer its memoized results are kept under.
+#define INTERPP_REGISTER_BASE( Class, BaseClass )\
+namespace Interpp\
+{\
+  [[maybe_unused]] static const bool _RegisteredBase_##Class##_##BaseClass = _InterppRegistry::AddBase< Class, BaseClass >();\
+\
+  static _BaseFieldsNode _BaseFieldsNode_##Class##_##BaseClass = { _Upcast< Class, BaseClass >, _FieldList< BaseClass >::Snapshot, NULL };\
+  [[maybe_unused]] static const bool _ListedBase_##Class##_##BaseClass = _FieldList< Class >::AddBase( &_BaseFieldsNode_##Class##_##BaseClass );\
+}
 
 //=================================================================================================
 
 namespace Interpp
 {
-  typedef std::string (*_interppMethod )( std::string&, std::string& );
+  class _ParamList;
+  class _PreparedCall;
+  class Value;
+
+  typedef bool (*_interppMethod )( void*, const _ParamList&, std::string& );
+  typedef _PreparedCall* (*_interppPrepare )( void*, const _ParamList& );
+  typedef void (*_interppInvoke )( void*, const Value*, unsigned long, Value& );
+  typedef void* (*_interppUpcast )( void* );
 
   //-------------------------------------------------------------------------------------------------
 
-  class _InterppRegistry
+  // registration flags (see INTERPP_REGISTER_METHOD_RETURN_FLAGS)
+  enum MethodFlags
   {
-  public:
-    static void* GetObject( std::string& objectName )
+    // the method may block, so ExecuteAsync() runs it on the async executor
+    LongRunning = 1,
+
+    // the method's result depends only on its object and arguments, so results are memoized (see
+    // InvalidateMemo())
+    Pure = 2
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  struct _InterppMethodInfo
+  {
+    _interppMethod call;
+    _interppPrepare prepare;
+    _interppInvoke invoke;
+    unsigned int flags;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // FNV-1a, as the registry's symbol table hashes names, usable in constant expressions
+  static constexpr unsigned long long _ConstHashName( const char* name )
+  {
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for( ; *name != '\0'; ++name )
     {
-      _interppObjectsIt = _interppObjects.find( objectName );
+      hash ^= ( unsigned char ) *name;
+      hash *= 1099511628211ULL;
+    }
+
+    return hash;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // A method declared by one of the INTERPP_REGISTER_METHOD macros. Nodes are constant-initialized,
+  // and link themselves into a pending list when their translation unit is initialized, which
+  // allocates nothing. The registry takes in every pending node in one pass on its next method
+  // lookup.
+  struct _MethodNode
+  {
+    constexpr _MethodNode( const std::type_info& type, const char* methodName, unsigned long long methodHash,
+                           const _InterppMethodInfo& info )
+      : type( &type ), methodName( methodName ), methodHash( methodHash ), info( info ), next( NULL ) {}
+
+    const std::type_info* type;
+    const char* methodName;
+    unsigned long long methodHash;
+    _InterppMethodInfo info;
+    _MethodNode* next;
+  };
+
+  // returns true, so that it can initialize a static
+  bool _RegisterMethodNode( _MethodNode* node );
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Open-addressing hash table keyed by non-zero 64-bit integers (a zero key marks an empty slot)
+  template< class Value >
+  class _FlatMap
+  {
+  public:
+    _FlatMap()
+      : _size( 0 ) {}
 
-      if( _interppObjectsIt == _interppObjects.end() )
+    const Value* Find( unsigned long long key ) const
+    {
+      if( _slots.empty() )
       {
         return NULL;
       }
 
-      return _interppObjectsIt->second.second;
+      unsigned long mask = _slots.size() - 1;
+
+      for( unsigned long i = _Hash( key ) & mask; ; i = ( i + 1 ) & mask )
+      {
+        if( _slots[i].key == key )
+        {
+          return &_slots[i].value;
+        }
+        else if( _slots[i].key == 0 )
+        {
+          return NULL;
+        }
+      }
+    }
+
+    Value& operator []( unsigned long long key )
+    {
+      // keep the load factor at or below 1/2
+      if( ( _size + 1 ) * 2 > _slots.size() )
+      {
+        _Rehash( _slots.empty() ? 16 : _slots.size() * 2 );
+      }
+
+      _Slot& slot = _Probe( key );
+
+      if( slot.key == 0 )
+      {
+        slot.key = key;
+        _size++;
+      }
+
+      return slot.value;
     }
 
-    template< class ObjectType >
-    static void AddObject( void* object, std::string& objectName )
+    // returns false if key was not in the map
+    bool Erase( unsigned long long key )
+    {
+      if( _slots.empty() )
+      {
+        return false;
+      }
+
+      unsigned long mask = _slots.size() - 1;
+      unsigned long hole = _Hash( key ) & mask;
+
+      while( _slots[hole].key != key )
+      {
+        if( _slots[hole].key == 0 )
+        {
+          return false;
+        }
+
+        hole = ( hole + 1 ) & mask;
+      }
+
+      // shift later entries of the probe run back into the hole, so that lookups need no tombstones
+      for( unsigned long i = ( hole + 1 ) & mask; _slots[i].key != 0; i = ( i + 1 ) & mask )
+      {
+        unsigned long home = _Hash( _slots[i].key ) & mask;
+
+        if( ( ( i - home ) & mask ) >= ( ( i - hole ) & mask ) )
+        {
+          _slots[hole] = _slots[i];
+          hole = i;
+        }
+      }
+
+      _slots[hole] = _Slot();
+      _size--;
+      return true;
+    }
+
+    unsigned long Size() const
     {
-      const std::type_info* objectType = &typeid( ObjectType );
-      std::string objectTypeName = objectType->name();
+      return _size;
+    }
+
+  private:
+    struct _Slot
+    {
+      _Slot()
+        : key( 0 ),
+          value() {}
 
-      _interppObjects[ objectName ] = std::make_pair( objectTypeName, object );
+      unsigned long long key;
+      Value value;
+    };
+
+    static unsigned long _Hash( unsigned long long key )
+    {
+      key ^= key >> 33;
+      key *= 0xff51afd7ed558ccdULL;
+      key ^= key >> 33;
+      return ( unsigned long ) key;
     }
 
-    static _interppMethod GetMethod( std::string& objectName, std::string& methodName )
+    _Slot& _Probe( unsigned long long key )
     {
-      _interppObjectsIt = _interppObjects.find( objectName );
+      unsigned long mask = _slots.size() - 1;
+      unsigned long i = _Hash( key ) & mask;
 
-      if( _interppObjectsIt == _interppObjects.end() )
+      while( _slots[i].key != key && _slots[i].key != 0 )
       {
-        return NULL;
+        i = ( i + 1 ) & mask;
       }
 
-      methodName += _interppObjectsIt->second.first;
-      _interppMethodsIt = _interppMethods.find( methodName );
+      return _slots[i];
+    }
+
+    void _Rehash( unsigned long capacity )
+    {
+      std::vector< _Slot > oldSlots( capacity );
+      oldSlots.swap( _slots );
 
-      if( _interppMethodsIt == _interppMethods.end() )
+      for( unsigned long i = 0; i < oldSlots.size(); ++i )
       {
-        return NULL;
+        if( oldSlots[i].key != 0 )
+        {
+          _Probe( oldSlots[i].key ) = oldSlots[i];
+        }
       }
+    }
+
+    std::vector< _Slot > _slots;
+    unsigned long _size;
+  };
 
-      return _interppMethodsIt->second;
+  //-------------------------------------------------------------------------------------------------
+
+  // Interns object, type and method names as small non-zero integer ids. The name strings live in a
+  // caller-owned append-only store, so copying a table copies no strings.
+  class _SymbolTable
+  {
+  public:
+    // returns 0 if name has not been interned
+    unsigned int Find( std::string_view name ) const;
+    unsigned int Intern( const std::string& name, std::deque< std::string >& nameStore );
+    unsigned int Intern( std::string_view name, unsigned long long hash, std::deque< std::string >& nameStore );
+
+    const std::string& Name( unsigned int id ) const
+    {
+      return *_names[id - 1];
     }
 
+  private:
+    struct _Slot
+    {
+      unsigned long long hash;
+      unsigned int id;
+    };
+
+    static unsigned long long _Hash( std::string_view name );
+    unsigned long _Probe( std::string_view name, unsigned long long hash ) const;
+
+    std::vector< _Slot > _slots;
+    std::vector< const std::string* > _names;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Identifies a registered object: the index of its slot in the object table plus one, with the
+  // slot's generation in the upper 32 bits. Commands address it as #handle, e.g. "#42.Method()".
+  // Unregistering an object bumps its slot's generation, so stale handles find nothing even once
+  // the slot holds another object. 0 is never a handle.
+  typedef unsigned long long ObjectHandle;
+
+  //-------------------------------------------------------------------------------------------------
+
+  struct _InterppObjectInfo
+  {
+    unsigned int typeId;
+    void* object;
+  };
+
+  // an entry of the object table; object is NULL while the slot is free
+  struct _ObjectSlot
+  {
+    _InterppObjectInfo info;
+    unsigned int generation;
+    unsigned int nameId;
+  };
+
+  // one base of a registered type; next is the index of the type's next base link plus one, or 0
+  struct _BaseLink
+  {
+    unsigned int baseTypeId;
+    _interppUpcast upcast;
+    unsigned int next;
+  };
+
+  template< class Type, class BaseType >
+  static void* _Upcast( void* object )
+  {
+    return static_cast< BaseType* >( ( Type* ) object );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  struct _RegistrySnapshot
+  {
+    _SymbolTable symbols;
+
+    // objects live in a dense table; names map to slot indices, and freed slots are reused
+    std::vector< _ObjectSlot > objectSlots;
+    std::vector< unsigned int > freeSlots;
+    _FlatMap< unsigned int > objects;
+
+    _FlatMap< _InterppMethodInfo > methods;
+
+    // type id -> index of the type's first base link
+    std::vector< _BaseLink > baseLinks;
+    _FlatMap< unsigned int > bases;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // The published snapshot of an Interpreter's registry, and the state its writers share; defined in
+  // Interpp.cpp. The default registry also holds every type's methods and bases.
+  struct _Registry;
+
+  _Registry& _DefaultRegistry();
+
+  // Lookups read the current _RegistrySnapshot without taking any locks, so any number of threads
+  // may Execute() concurrently. Registration copies the snapshot, applies the change and publishes
+  // the copy. Superseded snapshots are freed once no reader can still be using them (epoch-based
+  // reclamation). Registration is therefore O(registry size) and meant for startup, not hot paths.
+  // Objects are registered in, and looked up from, the given registry (the default one unless
+  // stated); methods and bases always go to the default one.
+  class _InterppRegistry
+  {
+  public:
+    // objectName may also be a handle written as #handle
+    static void* GetObject( std::string_view objectName, _Registry& registry = _DefaultRegistry() );
+    static void* GetObject( ObjectHandle handle, _Registry& registry = _DefaultRegistry() );
+
     template< class ObjectType >
-    static void AddMethod( _interppMethod method, std::string methodName )
+    static ObjectHandle AddObject( void* object, const std::string& objectName, _Registry& registry = _DefaultRegistry() )
+    {
+      return _AddObject( registry, typeid( ObjectType ).name(), object, objectName );
+    }
+
+    // returns false if no object is registered under objectName or handle
+    static bool RemoveObject( std::string_view objectName, _Registry& registry = _DefaultRegistry() );
+    static bool RemoveObject( ObjectHandle handle, _Registry& registry = _DefaultRegistry() );
+
+    // returns a zeroed _InterppMethodInfo if not found, and sets *object if the object was found;
+    // for an inherited method, *object is converted to the base type that has it, so callers that
+    // need to tell objects apart take *registeredObject, the object as it was registered
+    static _InterppMethodInfo GetMethod( std::string_view objectName, std::string_view methodName, void** object = NULL,
+                                         _Registry& registry = _DefaultRegistry(), void** registeredObject = NULL );
+    static _InterppMethodInfo GetMethod( ObjectHandle handle, std::string_view methodName, void** object = NULL,
+                                         _Registry& registry = _DefaultRegistry(), void** registeredObject = NULL );
+
+    // the two halves of GetMethod(), for callers that cache resolutions by object and type:
+    // GetObject() also returns the object's type id, which FindMethod() takes to look up the method
+    // and convert object as GetMethod() would
+    static void* GetObject( std::string_view objectName, unsigned int& typeId, _Registry& registry = _DefaultRegistry() );
+    static _InterppMethodInfo FindMethod( unsigned int typeId, std::string_view methodName, void*& object );
+
+    template< class ObjectType, class BaseType >
+    static bool AddBase()
     {
-      const std::type_info* objectType = &typeid( ObjectType );
-      methodName += objectType->name();
+      static_assert( std::is_base_of< BaseType, ObjectType >::value, "BaseType must be a base of ObjectType" );
+      _AddBase( typeid( ObjectType ).name(), typeid( BaseType ).name(), _Upcast< ObjectType, BaseType > );
+      return true;
+    }
 
-      _interppMethods[ methodName ] = method;
+    template< class ObjectType >
+    static void AddMethod( const _InterppMethodInfo& methodInfo, const std::string& methodName )
+    {
+      _AddMethod( typeid( ObjectType ).name(), methodInfo, methodName );
     }
 
   private:
-    static std::map< std::string, std::pair< std::string, void* > > _interppObjects;
-    static std::map< std::string, std::pair< std::string, void* > >::const_iterator _interppObjectsIt;
+    static ObjectHandle _AddObject( _Registry& registry, const std::string& typeName, void* object, const std::string& objectName );
+    static void _AddMethod( const std::string& typeName, const _InterppMethodInfo& methodInfo, const std::string& methodName );
+    static void _AddBase( const std::string& typeName, const std::string& baseTypeName, _interppUpcast upcast );
+  };
+
+  // changes whenever a registration is published in registry, or in the default registry, which
+  // holds every type's methods and bases, so a cached resolution made while it had the same value is
+  // still current. Registrations in other interpreters leave it unchanged.
+  unsigned long long _RegistryEpoch( _Registry& registry = _DefaultRegistry() );
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Each registration copies the registry, so registering thousands of objects one by one is
+  // quadratic. While a RegistrationBatch exists, registrations made by its thread are applied to one
+  // private copy, which is published when the last batch on that thread is destroyed. Until then,
+  // lookups do not see them and other threads' registrations wait.
+  class Interpreter;
+
+  class RegistrationBatch
+  {
+  public:
+    // batches registrations in the default interpreter, or in interpreter
+    RegistrationBatch();
+    explicit RegistrationBatch( Interpreter& interpreter );
+    ~RegistrationBatch();
+
+  private:
+    RegistrationBatch( const RegistrationBatch& );
+    RegistrationBatch& operator =( const RegistrationBatch& );
+
+    void _Open();
+
+    _Registry* _registry;
+  };
 
-    static std::map< std::string, _interppMethod > _interppMethods;
-    static std::map< std::string, _interppMethod >::const_iterator _interppMethodsIt;
+  //-------------------------------------------------------------------------------------------------
+
+  // Execute() and the batch runners hold an _ArenaScope while they work. Temporaries allocated
+  // through _ArenaResource() within one come from a per-thread arena, which is rewound when the
+  // outermost scope on the thread ends, so steady-state calls do not touch the heap. Outside any
+  // scope, _ArenaResource() is the heap.
+  class _ArenaScope
+  {
+  public:
+    _ArenaScope();
+    ~_ArenaScope();
+
+  private:
+    _ArenaScope( const _ArenaScope& );
+    _ArenaScope& operator =( const _ArenaScope& );
   };
 
+  std::pmr::memory_resource* _ArenaResource();
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Scans text from position on for the bytes that delimit commands, params and lists (. ( ) , [ ]
+  // and both quotes), 16 bytes at a time with SSE2 on x86-64. Stores the offsets of up to capacity
+  // of them, and advances position past the bytes scanned. Offsets are 32-bit, so text is assumed
+  // to be under 4GB.
+  void _FindStructure( std::string_view text, std::size_t& position, unsigned int* offsets, unsigned long capacity, unsigned long& count );
+
+  // the number of offsets found per call when walking a list
+  static const unsigned long _listChunk = 256;
+
   //-------------------------------------------------------------------------------------------------
 
+  // Splits a param string into string_view slices of the original command. Nothing is copied or
+  // unescaped here: escaped quotes are only resolved when a param is converted to a string. Up to
+  // _inlineParams params are held without touching the heap.
   class _ParamList
   {
   public:
-    _ParamList( std::string& params )
+    explicit _ParamList( std::string_view params )
+      : _overflow( _ArenaResource() ),
+        _size( 0 )
     {
       if( params.size() == 0 )
       {
         return;
       }
 
-      unsigned long commaPos = 0;
-      unsigned long paramStart = 0;
-      unsigned long paramEnd = 0;
+      std::size_t commaPos = 0;
+      std::size_t paramStart = 0;
+      std::size_t paramEnd = 0;
 
-      while( commaPos != std::string::npos )
+      while( commaPos != std::string_view::npos )
       {
         // skip spaces before param
         while( paramStart < params.size() - 1 &&
@@ -192,17 +633,18 @@ namespace Interpp
         commaPos = paramStart;
 
         //if param is a string, skip to next inverted comma
-        if( params[paramStart] == '\'' )
+        bool escaped = false;
+
+        if( paramStart < params.size() && params[paramStart] == '\'' )
         {
           while( true )
           {
-            commaPos = params.find( "'", commaPos + 1 );
+            commaPos = params.find( '\'', commaPos + 1 );
 
-            if( commaPos != std::string::npos &&
+            if( commaPos != std::string_view::npos &&
                 params[commaPos - 1] == '\\' )
             {
-              params.erase( commaPos - 1, 1 );
-              commaPos--;
+              escaped = true;
             }
             else
             {
@@ -210,11 +652,16 @@ namespace Interpp
             }
           }
         }
+        // if param is a list, skip to its closing bracket
+        else if( paramStart < params.size() && params[paramStart] == '[' )
+        {
+          commaPos = _ListEnd( params, paramStart );
+        }
 
         // find end of current param
-        commaPos = params.find( ",", commaPos );
+        commaPos = params.find( ',', commaPos );
 
-        if( commaPos != std::string::npos )
+        if( commaPos != std::string_view::npos )
         {
           paramEnd = commaPos;
         }
@@ -223,7 +670,7 @@ namespace Interpp
           paramEnd = params.size();
         }
 
-        if( paramStart != paramEnd )
+        if( paramStart < paramEnd )
         {
           // skip spaces after param
           while( paramEnd > 0 &&
@@ -232,381 +679,2611 @@ namespace Interpp
             paramEnd--;
           }
         }
+        else
+        {
+          paramEnd = paramStart;
+        }
+
+        // if the param is a string, take contents within inverted commas
+        bool quoted = false;
 
-        // if the param is a string, copy contents within inverted commas
-        if( ( params[paramStart] == '\'' || params[paramStart] == '\"' ) &&
+        if( paramEnd - paramStart >= 2 &&
+            ( params[paramStart] == '\'' || params[paramStart] == '\"' ) &&
             ( params[paramEnd-1] == '\'' || params[paramEnd-1] == '\"' ) )
         {
           paramStart++;
           paramEnd--;
+          quoted = true;
         }
 
         // push param to params
-        _params.push_back( params.substr( paramStart, paramEnd - paramStart ) );
+        _Param param = { params.substr( paramStart, paramEnd - paramStart ), quoted, escaped };
+
+        if( _size < _inlineParams )
+        {
+          _inline[_size] = param;
+        }
+        else
+        {
+          _overflow.push_back( param );
+        }
+
+        _size++;
 
         // start next param after comma
         paramStart = commaPos + 1;
       }
     }
 
-    std::string operator []( unsigned long i ) const
+    // returns the raw param text (without surrounding inverted commas)
+    std::string_view operator []( unsigned long i ) const
     {
-      if( i < _params.size() )
+      if( i < _size )
       {
-        return _params[i];
+        return _At( i ).text;
       }
 
-      return "";
+      return std::string_view();
     }
 
-  private:
-    std::vector< std::string > _params;
-  };
-
-  //-------------------------------------------------------------------------------------------------
-
-  template< class ToType, class FromType >
-  static ToType ConvertValue( FromType fromValue )
-  {
-    // convert from string
-    // ===================
-    if( typeid( FromType ) == typeid( std::string ) )
+    // returns the param text with escaped inverted commas resolved
+    std::string Unescaped( unsigned long i ) const
     {
-      std::string fromString = *( ( std::string* ) ( &fromValue ) );
-
-      // ToType is string
-      if( typeid( ToType ) == typeid( std::string ) )
-      {
-        return *reinterpret_cast< ToType* >( &fromString );
-      }
-      // ToType is char*
-      else if( typeid( ToType ) == typeid( char* ) )
-      {
-        return *reinterpret_cast< ToType* >( &fromString );
-      }
-      // ToType is char
-      else if( typeid( ToType ) == typeid( char ) )
-      {
-        char returnValue = fromString[0];
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is unsigned char
-      else if( typeid( ToType ) == typeid( unsigned char ) )
-      {
-        unsigned char returnValue = atoi( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is double
-      else if( typeid( ToType ) == typeid( double ) )
-      {
-        double returnValue = atof( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is float
-      else if( typeid( ToType ) == typeid( float ) )
-      {
-        float returnValue = ( float ) atof( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is int
-      else if( typeid( ToType ) == typeid( int ) )
-      {
-        int returnValue = atoi( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is short
-      else if( typeid( ToType ) == typeid( short ) )
-      {
-        short returnValue = ( short ) atoi( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is long
-      else if( typeid( ToType ) == typeid( long ) )
-      {
-        long returnValue = atol( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is unsigned int
-      else if( typeid( ToType ) == typeid( unsigned int ) )
-      {
-        unsigned int returnValue = atoi( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
-      }
-      // ToType is unsigned short
-      else if( typeid( ToType ) == typeid( unsigned short ) )
+      if( i >= _size )
       {
-        unsigned short returnValue = ( short ) atoi( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
+        return std::string();
       }
-      // ToType is unsigned long
-      else if( typeid( ToType ) == typeid( unsigned long ) )
+
+      const _Param& param = _At( i );
+
+      if( !param.escaped )
       {
-        unsigned long returnValue = atol( fromString.c_str() );
-        return *reinterpret_cast< ToType* >( &returnValue );
+        return std::string( param.text );
       }
-      // ToType is bool
-      else if( typeid( ToType ) == typeid( bool ) )
+
+      std::string unescaped;
+      unescaped.reserve( param.text.size() );
+
+      for( std::size_t c = 0; c < param.text.size(); ++c )
       {
-        bool returnValue = fromString == "true";
-        return *reinterpret_cast< ToType* >( &returnValue );
+        if( param.text[c] != '\\' || c + 1 == param.text.size() || param.text[c + 1] != '\'' )
+        {
+          unescaped += param.text[c];
+        }
       }
+
+      return unescaped;
+    }
+
+    unsigned long Size() const
+    {
+      return _size;
+    }
+
+    bool IsQuoted( unsigned long i ) const
+    {
+      return i < _size && _At( i ).quoted;
+    }
+
+    // whether Unescaped( i ) differs from the raw text
+    bool IsEscaped( unsigned long i ) const
+    {
+      return i < _size && _At( i ).escaped;
+    }
+
+    // true if there are no params, or only spaces where one would be (as in "Method( )")
+    bool IsBlank() const
+    {
+      return _size == 0 || ( _size == 1 && !_At( 0 ).quoted && _At( 0 ).text.empty() );
     }
 
-    // convert to string
-    // =================
-    else if( typeid( ToType ) == typeid( std::string ) )
+    // an unquoted "?" marks a param to be bound later via CompiledCommand::Bind()
+    bool IsPlaceholder( unsigned long i ) const
     {
-      std::ostringstream returnStream;
+      return i < _size && !_At( i ).quoted && _At( i ).text == "?";
+    }
+
+  private:
+    struct _Param
+    {
+      std::string_view text;
+      bool quoted;
+      bool escaped;
+    };
+
+    // returns the position of the bracket that closes the list opening at start, or start if the
+    // list is not closed
+    static std::size_t _ListEnd( std::string_view params, std::size_t start )
+    {
+      std::size_t close = params.find( ']', start + 1 );
 
-      // FromType is char*
-      if( typeid( FromType ) == typeid( char* ) )
+      if( close == std::string_view::npos )
       {
-        returnStream << *reinterpret_cast< char** >( &fromValue );
+        return start;
       }
-      // FromType is char
-      else if( typeid( FromType ) == typeid( char ) )
+
+      // the common case, a list of numbers, holds no brackets or quotes
+      std::string_view elements = params.substr( start + 1, close - start - 1 );
+
+      if( elements.find( '[' ) == std::string_view::npos &&
+          elements.find( '\'' ) == std::string_view::npos &&
+          elements.find( '\"' ) == std::string_view::npos )
       {
-        returnStream << *reinterpret_cast< char* >( &fromValue );
+        return close;
       }
-      // FromType is unsigned char
-      else if( typeid( FromType ) == typeid( unsigned char ) )
-      {
-        returnStream << *reinterpret_cast< unsigned short* >( &fromValue );
+
+      // otherwise only the delimiters can open or close a list or string, so walk those
+      unsigned int offsets[_listChunk];
+      std::size_t position = start;
+      unsigned long depth = 0;
+      char quote = '\0';
+
+      while( position < params.size() )
+      {
+        unsigned long count;
+        _FindStructure( params, position, offsets, _listChunk, count );
+
+        for( unsigned long o = 0; o < count; ++o )
+        {
+          std::size_t i = offsets[o];
+
+          if( quote != '\0' )
+          {
+            if( params[i] == quote && params[i - 1] != '\\' )
+            {
+              quote = '\0';
+            }
+          }
+          else if( params[i] == '\'' || params[i] == '\"' )
+          {
+            quote = params[i];
+          }
+          else if( params[i] == '[' )
+          {
+            depth++;
+          }
+          else if( params[i] == ']' && --depth == 0 )
+          {
+            return i;
+          }
+        }
+      }
+
+      return start;
+    }
+
+    const _Param& _At( unsigned long i ) const
+    {
+      return i < _inlineParams ? _inline[i] : _overflow[i - _inlineParams];
+    }
+
+    static const unsigned long _inlineParams = 16;
+
+    _Param _inline[_inlineParams];
+    std::pmr::vector< _Param > _overflow;
+    unsigned long _size;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Converts values of Type to and from command text. The conversion for each type is resolved at
+  // compile time. Specialize ValueConverter to pass your own types to and from registered methods:
+  //
+  //   template<> struct Interpp::ValueConverter< Point >
+  //   {
+  //     static bool FromString( std::string_view text, Point& value ); // false if text is invalid
+  //     static void ToString( const Point& value, std::string& text ); // appends value to text
+  //   };
+  template< class Type, class Enable = void >
+  struct ValueConverter
+  {
+    static_assert( sizeof( Type ) == 0, "Interpp: no ValueConverter specialization for this type" );
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Type >
+  struct ValueConverter< Type, typename std::enable_if< std::is_integral< Type >::value &&
+                                                        !std::is_same< Type, bool >::value &&
+                                                        !std::is_same< Type, char >::value >::type >
+  {
+    static bool FromString( std::string_view text, Type& value )
+    {
+      const char* first = text.data();
+      const char* last = first + text.size();
+
+      // a leading '+' is skipped, but not in front of another sign: "+-5" stays invalid
+      if( first != last && *first == '+' )
+      {
+        first++;
+
+        if( first != last && *first == '-' )
+        {
+          return false;
+        }
+      }
+
+      std::from_chars_result parsed = std::from_chars( first, last, value );
+      return parsed.ec == std::errc() && parsed.ptr == last;
+    }
+
+    static void ToString( Type value, std::string& text )
+    {
+      char buffer[24];
+      std::to_chars_result formatted = std::to_chars( buffer, buffer + sizeof( buffer ), value );
+      text.append( buffer, formatted.ptr - buffer );
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Type >
+  struct ValueConverter< Type, typename std::enable_if< std::is_floating_point< Type >::value >::type >
+  {
+    static bool FromString( std::string_view text, Type& value )
+    {
+      const char* first = text.data();
+      const char* last = first + text.size();
+
+      // a leading '+' is skipped, but not in front of another sign: "+-5" stays invalid
+      if( first != last && *first == '+' )
+      {
+        first++;
+
+        if( first != last && *first == '-' )
+        {
+          return false;
+        }
+      }
+
+      std::from_chars_result parsed = std::from_chars( first, last, value );
+      return parsed.ec == std::errc() && parsed.ptr == last;
+    }
+
+    static void ToString( Type value, std::string& text )
+    {
+      // 6 significant digits, as std::ostream prints by default
+      char buffer[32];
+      std::to_chars_result formatted = std::to_chars( buffer, buffer + sizeof( buffer ), value, std::chars_format::general, 6 );
+      text.append( buffer, formatted.ptr - buffer );
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template<>
+  struct ValueConverter< bool >
+  {
+    static bool FromString( std::string_view text, bool& value )
+    {
+      value = text == "true" || text == "1";
+      return value || text == "false" || text == "0";
+    }
+
+    static void ToString( bool value, std::string& text )
+    {
+      text += value ? "true" : "false";
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template<>
+  struct ValueConverter< char >
+  {
+    static bool FromString( std::string_view text, char& value )
+    {
+      value = text.empty() ? '\0' : text[0];
+      return text.size() == 1;
+    }
+
+    static void ToString( char value, std::string& text )
+    {
+      text += value;
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template<>
+  struct ValueConverter< std::string >
+  {
+    static bool FromString( std::string_view text, std::string& value )
+    {
+      value.assign( text.data(), text.size() );
+      return true;
+    }
+
+    static void ToString( const std::string& value, std::string& text )
+    {
+      text += value;
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template<>
+  struct ValueConverter< std::string_view >
+  {
+    static bool FromString( std::string_view text, std::string_view& value )
+    {
+      value = text;
+      return true;
+    }
+
+    static void ToString( std::string_view value, std::string& text )
+    {
+      text += value;
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // C strings can be returned from methods, but not taken as params (there is nothing to own them)
+  template< class Type >
+  struct ValueConverter< Type, typename std::enable_if< std::is_same< Type, char* >::value ||
+                                                        std::is_same< Type, const char* >::value >::type >
+  {
+    static void ToString( const char* value, std::string& text )
+    {
+      if( value != NULL )
+      {
+        text += value;
+      }
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // converts text to value, returning false if text is not a valid ToType. Empty text (e.g. a
+  // missing param) converts to a default-constructed ToType.
+  template< class ToType >
+  static bool ConvertValue( std::string_view text, ToType& value )
+  {
+    if( text.empty() )
+    {
+      value = ToType();
+      return true;
+    }
+
+    return ValueConverter< ToType >::FromString( text, value );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // converts a value to text (ToType is std::string), or text to a value (a default-constructed
+  // ToType if the text is not valid)
+  template< class ToType, class FromType >
+  static ToType ConvertValue( const FromType& fromValue )
+  {
+    if constexpr( std::is_same< ToType, std::string >::value )
+    {
+      std::string text;
+      ValueConverter< typename std::decay< FromType >::type >::ToString( fromValue, text );
+      return text;
+    }
+    else
+    {
+      ToType value = ToType();
+
+      if( !ConvertValue( std::string_view( fromValue ), value ) )
+      {
+        value = ToType();
+      }
+
+      return value;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Parses a list of numbers, its elements separated by commas and spaces, straight from the text
+  // with std::from_chars. Returns false on anything else (brackets, quotes, empty elements), or if
+  // an element is not a valid Type, leaving such lists to _ParamList.
+  template< class Type, class Allocator >
+  static bool _ParseNumberList( std::string_view elements, std::vector< Type, Allocator >& values )
+  {
+    const char* next = elements.data();
+    const char* last = next + elements.size();
+
+    values.clear();
+
+    while( next != last && *next == ' ' )
+    {
+      next++;
+    }
+
+    // "[]" and "[ ]" are empty lists
+    if( next == last )
+    {
+      return true;
+    }
+
+    while( true )
+    {
+      // a leading '+' is skipped, but not in front of another sign, as in FromString()
+      if( *next == '+' && ( ++next == last || *next == '-' ) )
+      {
+        return false;
+      }
+
+      Type value;
+      std::from_chars_result parsed = std::from_chars( next, last, value );
+
+      if( parsed.ec != std::errc() )
+      {
+        return false;
+      }
+
+      // size the list from the width of its first element
+      if( values.empty() )
+      {
+        values.reserve( elements.size() / ( parsed.ptr - elements.data() + 1 ) + 1 );
+      }
+
+      values.push_back( value );
+
+      next = parsed.ptr;
+
+      while( next != last && *next == ' ' )
+      {
+        next++;
+      }
+
+      if( next == last )
+      {
+        return true;
+      }
+      else if( *next != ',' )
+      {
+        return false;
+      }
+
+      next++;
+
+      while( next != last && *next == ' ' )
+      {
+        next++;
+      }
+
+      // a trailing comma leaves an empty element
+      if( next == last )
+      {
+        return false;
+      }
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // appends value in inverted commas, escaping those within it, as a string param is written
+  static void _AppendQuoted( std::string_view value, std::string& text )
+  {
+    text += '\'';
+
+    for( char c : value )
+    {
+      if( c == '\'' )
+      {
+        text += '\\';
+      }
+
+      text += c;
+    }
+
+    text += '\'';
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Lists are written [a, b, c], and convert to and from std::vector. Elements convert as params of
+  // their type do, so strings are quoted and lists can be nested.
+  template< class Type, class Allocator >
+  struct ValueConverter< std::vector< Type, Allocator > >
+  {
+    static bool FromString( std::string_view text, std::vector< Type, Allocator >& value )
+    {
+      if( text.size() < 2 || text.front() != '[' || text.back() != ']' )
+      {
+        return false;
+      }
+
+      std::string_view elements = text.substr( 1, text.size() - 2 );
+
+      if constexpr( std::is_arithmetic< Type >::value &&
+                    !std::is_same< Type, bool >::value &&
+                    !std::is_same< Type, char >::value )
+      {
+        if( _ParseNumberList( elements, value ) )
+        {
+          return true;
+        }
+      }
+
+      if( elements.find_first_not_of( ' ' ) == std::string_view::npos )
+      {
+        value.clear();
+        return true;
+      }
+
+      _ParamList params( elements );
+      value.resize( params.Size() );
+
+      for( unsigned long i = 0; i < params.Size(); ++i )
+      {
+        Type element;
+
+        if constexpr( std::is_same< Type, std::string >::value )
+        {
+          element = params.Unescaped( i );
+        }
+        else if( params[i].empty() || !ConvertValue( params[i], element ) )
+        {
+          // unlike a missing param, a missing element is an error
+          return false;
+        }
+
+        value[i] = std::move( element );
+      }
+
+      return true;
+    }
+
+    static void ToString( const std::vector< Type, Allocator >& value, std::string& text )
+    {
+      text += '[';
+
+      for( std::size_t i = 0; i < value.size(); ++i )
+      {
+        if( i != 0 )
+        {
+          text += ", ";
+        }
+
+        if constexpr( std::is_same< Type, std::string >::value || std::is_same< Type, std::string_view >::value )
+        {
+          // quoted, so that the list reads back as it was written
+          _AppendQuoted( value[i], text );
+        }
+        else
+        {
+          ValueConverter< Type >::ToString( value[i], text );
+        }
+      }
+
+      text += ']';
+    }
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // A native argument or return value for typed calls (see Invoke()). Integers are held as long
+  // long and floating point values as double. Error values carry a message in place of a result.
+  class Value
+  {
+  public:
+    enum Type
+    {
+      Void,
+      Bool,
+      Int,
+      Real,
+      String,
+      Error
+    };
+
+    Value()
+      : _type( Void ),
+        _int( 0 ) {}
+
+    Value( bool value )
+      : _type( Bool ),
+        _bool( value ) {}
+
+    template< class Integral, typename std::enable_if< std::is_integral< Integral >::value &&
+                                                        !std::is_same< Integral, bool >::value &&
+                                                        !std::is_same< Integral, char >::value, int >::type = 0 >
+    Value( Integral value )
+      : _type( Int ),
+        _int( ( long long ) value ) {}
+
+    template< class Floating, typename std::enable_if< std::is_floating_point< Floating >::value, int >::type = 0 >
+    Value( Floating value )
+      : _type( Real ),
+        _real( ( double ) value ) {}
+
+    Value( char value )
+      : _type( String ),
+        _int( 0 ),
+        _string( 1, value ) {}
+
+    Value( const char* value )
+      : _type( String ),
+        _int( 0 ),
+        _string( value ) {}
+
+    Value( std::string_view value )
+      : _type( String ),
+        _int( 0 ),
+        _string( value ) {}
+
+    Value( const std::string& value )
+      : _type( String ),
+        _int( 0 ),
+        _string( value ) {}
+
+    static Value MakeError( const std::string& message )
+    {
+      Value error( message );
+      error._type = Error;
+      return error;
+    }
+
+    Type GetType() const
+    {
+      return _type;
+    }
+
+    bool IsVoid() const
+    {
+      return _type == Void;
+    }
+
+    bool IsError() const
+    {
+      return _type == Error;
+    }
+
+    bool AsBool() const
+    {
+      return _bool;
+    }
+
+    long long AsInt() const
+    {
+      return _int;
+    }
+
+    double AsReal() const
+    {
+      return _real;
+    }
+
+    // the text of a String, or the message of an Error
+    const std::string& AsString() const
+    {
+      return _string;
+    }
+
+    // the value as Execute() would have returned it
+    std::string ToString() const
+    {
+      std::string text;
+      AppendTo( text );
+      return text;
+    }
+
+    // as ToString(), appended to text
+    void AppendTo( std::string& text ) const
+    {
+      switch( _type )
+      {
+        case Bool:
+          ValueConverter< bool >::ToString( _bool, text );
+          break;
+        case Int:
+          ValueConverter< long long >::ToString( _int, text );
+          break;
+        case Real:
+          ValueConverter< double >::ToString( _real, text );
+          break;
+        case String:
+        case Error:
+          text += _string;
+          break;
+        default:
+          break;
+      }
+    }
+
+    // makes this a String in place, reusing the capacity of the text it held, for callers that refill
+    // one Value many times
+    void _Assign( std::string_view value )
+    {
+      _type = String;
+      _int = 0;
+      _string.assign( value.data(), value.size() );
+    }
+
+  private:
+    Type _type;
+
+    union
+    {
+      bool _bool;
+      long long _int;
+      double _real;
+    };
+
+    std::string _string;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Phases of a call timed when Interpp is built with INTERPP_PROFILING=1 (see DumpProfile())
+  enum ProfilePhase
+  {
+    ProfileSplit,     // splitting the command into object, method and params
+    ProfileLookup,    // finding the object and method in the registry
+    ProfileParse,     // tokenizing the params
+    ProfileConvert,   // converting params to native args and the return value back
+    ProfileMethod,    // the registered method itself
+    ProfileTotal,     // all of the above
+    _ProfilePhaseCount
+  };
+
+  // Per-method call counts and phase latency histograms, as text or JSON. Both are empty unless
+  // INTERPP_PROFILING is enabled.
+  std::string DumpProfile();
+  std::string DumpProfileJson();
+  void ResetProfile();
+
+  //-------------------------------------------------------------------------------------------------
+
+  struct _MethodProfile;
+
+  // phase times measured before the method is known, held per thread until its call starts
+  unsigned long long* _ProfilePending();
+
+  // returns this thread's profile for methodName, counting a call and taking the pending phase times
+  _MethodProfile* _ProfileBegin( const char* methodName, unsigned long long& pendingNs );
+  void _ProfileRecord( _MethodProfile* profile, ProfilePhase phase, unsigned long long ns );
+
+  static unsigned long long _ProfileNow()
+  {
+    return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Times the phases before a method is known. Compiles to nothing unless INTERPP_PROFILING is enabled.
+  template< bool Enabled = INTERPP_PROFILING != 0 >
+  class _PhaseTimer
+  {
+  public:
+    _PhaseTimer()
+      : _last( _ProfileNow() )
+    {
+      unsigned long long* pending = _ProfilePending();
+
+      for( int i = 0; i < _ProfilePhaseCount; ++i )
+      {
+        pending[i] = 0;
+      }
+    }
+
+    // charges the time since the previous lap to phase
+    void Lap( ProfilePhase phase )
+    {
+      unsigned long long now = _ProfileNow();
+      _ProfilePending()[phase] += now - _last;
+      _last = now;
+    }
+
+  private:
+    unsigned long long _last;
+  };
+
+  template<>
+  class _PhaseTimer< false >
+  {
+  public:
+    void Lap( ProfilePhase ) {}
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Times one call of a registered method, from its thunk. Compiles to nothing unless INTERPP_PROFILING
+  // is enabled.
+  template< bool Enabled = INTERPP_PROFILING != 0 >
+  class _ProfileCall
+  {
+  public:
+    explicit _ProfileCall( const char* methodName )
+      : _profile( _ProfileBegin( methodName, _totalNs ) ),
+        _start( _ProfileNow() ),
+        _last( _start ),
+        _ns() {}
+
+    ~_ProfileCall()
+    {
+      for( int i = 0; i < ProfileTotal; ++i )
+      {
+        if( _ns[i] != 0 )
+        {
+          _ProfileRecord( _profile, ( ProfilePhase ) i, _ns[i] );
+        }
+      }
+
+      _ProfileRecord( _profile, ProfileTotal, _totalNs + _ProfileNow() - _start );
+    }
+
+    // charges the time since the previous lap to phase
+    void Lap( ProfilePhase phase )
+    {
+      unsigned long long now = _ProfileNow();
+      _ns[phase] += now - _last;
+      _last = now;
+    }
+
+  private:
+    unsigned long long _totalNs;
+    _MethodProfile* _profile;
+    unsigned long long _start;
+    unsigned long long _last;
+    unsigned long long _ns[ProfileTotal];
+  };
+
+  template<>
+  class _ProfileCall< false >
+  {
+  public:
+    explicit _ProfileCall( const char* ) {}
+
+    void Lap( ProfilePhase ) {}
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // converts param i of params, resolving escaped inverted commas only if the target is a string
+  template< class Type >
+  static bool _ConvertParam( const _ParamList& params, unsigned long i, Type& value )
+  {
+    if constexpr( std::is_same< Type, std::string >::value )
+    {
+      value = params.Unescaped( i );
+      return true;
+    }
+    else
+    {
+      return ConvertValue( params[i], value );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  static std::string _InvalidParamError( unsigned long i )
+  {
+    return "Error: invalid param " + std::to_string( i + 1 );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Cl, class Rt, class... Args, class Tuple, std::size_t... Is >
+  static Rt _Apply( Cl* object, Rt ( Cl::*methPtr )( Args... ), Tuple& args, std::index_sequence< Is... > )
+  {
+    return ( object->*methPtr )( std::get< Is >( args )... );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // calls methPtr with args and writes its return value (if any) to result
+  template< class Cl, class Rt, class... Args, class Tuple >
+  static void _ApplyToString( Cl* object, Rt ( Cl::*methPtr )( Args... ), Tuple& args, std::string& result )
+  {
+    if constexpr( std::is_void< Rt >::value )
+    {
+      _Apply( object, methPtr, args, std::index_sequence_for< Args... >() );
+    }
+    else
+    {
+      ValueConverter< typename std::decay< Rt >::type >::ToString( _Apply( object, methPtr, args, std::index_sequence_for< Args... >() ), result );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // converts params into args, stopping at the first param that fails to convert
+  template< class Tuple, std::size_t... Is >
+  static bool _ConvertParams( const _ParamList& params, Tuple& args, unsigned long& converted, std::index_sequence< Is... > )
+  {
+    return ( ( _ConvertParam( params, Is, std::get< Is >( args ) ) && ( ++converted, true ) ) && ... );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Appends the method's return value to result, or returns false having appended an error. Every
+  // param is converted before the method is called, so that an invalid param is reported instead of
+  // reaching the method.
+  template< class Cl, class Rt, class... Args >
+  static bool _Call_Method( Cl* object, Rt ( Cl::*methPtr )( Args... ), const _ParamList& params, std::string& result,
+                            const char* methodName )
+  {
+    _ProfileCall<> profile( methodName );
+    std::tuple< typename std::decay< Args >::type... > args;
+    unsigned long converted = 0;
+
+    if( !_ConvertParams( params, args, converted, std::index_sequence_for< Args... >() ) )
+    {
+      result += _InvalidParamError( converted );
+      return false;
+    }
+
+    profile.Lap( ProfileConvert );
+
+    if constexpr( std::is_void< Rt >::value )
+    {
+      _Apply( object, methPtr, args, std::index_sequence_for< Args... >() );
+      profile.Lap( ProfileMethod );
+    }
+    else
+    {
+      Rt returned = _Apply( object, methPtr, args, std::index_sequence_for< Args... >() );
+      profile.Lap( ProfileMethod );
+      ValueConverter< typename std::decay< Rt >::type >::ToString( returned, result );
+      profile.Lap( ProfileConvert );
+    }
+
+    return true;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Type >
+  static bool _InRange( long long value )
+  {
+    if constexpr( std::is_signed< Type >::value )
+    {
+      return value >= ( long long ) std::numeric_limits< Type >::min() &&
+             value <= ( long long ) std::numeric_limits< Type >::max();
+    }
+    else
+    {
+      return value >= 0 && ( unsigned long long ) value <= std::numeric_limits< Type >::max();
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // converts a typed argument to a native param. Numeric kinds convert to one another as long as
+  // the value is representable; String values are parsed as Execute() would parse them.
+  template< class Type >
+  static bool _FromValue( const Value& value, Type& nativeValue )
+  {
+    switch( value.GetType() )
+    {
+      case Value::Void:
+        // a missing argument takes its default value
+        nativeValue = Type();
+        return true;
+
+      case Value::Error:
+        return false;
+
+      case Value::String:
+        if constexpr( std::is_same< Type, std::string >::value )
+        {
+          nativeValue = value.AsString();
+          return true;
+        }
+        else
+        {
+          return ConvertValue( std::string_view( value.AsString() ), nativeValue );
+        }
+
+      default:
+        break;
+    }
+
+    if constexpr( std::is_same< Type, std::string >::value )
+    {
+      nativeValue = value.ToString();
+      return true;
+    }
+    else if constexpr( std::is_same< Type, bool >::value )
+    {
+      nativeValue = value.GetType() == Value::Bool ? value.AsBool() :
+                    value.GetType() == Value::Int ? value.AsInt() != 0 : value.AsReal() != 0;
+      return true;
+    }
+    else if constexpr( std::is_integral< Type >::value )
+    {
+      long long integer = value.GetType() == Value::Bool ? value.AsBool() :
+                          value.GetType() == Value::Int ? value.AsInt() : ( long long ) value.AsReal();
+
+      if( ( value.GetType() == Value::Real && integer != value.AsReal() ) || !_InRange< Type >( integer ) )
+      {
+        return false;
+      }
+
+      nativeValue = ( Type ) integer;
+      return true;
+    }
+    else if constexpr( std::is_floating_point< Type >::value )
+    {
+      nativeValue = value.GetType() == Value::Bool ? ( Type ) value.AsBool() :
+                    value.GetType() == Value::Int ? ( Type ) value.AsInt() : ( Type ) value.AsReal();
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // converts a native return value to a typed result, falling back to ValueConverter text
+  template< class Type >
+  static Value _ToValue( const Type& nativeValue )
+  {
+    if constexpr( std::is_arithmetic< Type >::value ||
+                  std::is_same< Type, std::string >::value ||
+                  std::is_same< Type, std::string_view >::value )
+    {
+      return Value( nativeValue );
+    }
+    else if constexpr( std::is_same< Type, char* >::value || std::is_same< Type, const char* >::value )
+    {
+      return Value( nativeValue ? nativeValue : "" );
+    }
+    else
+    {
+      std::string text;
+      ValueConverter< Type >::ToString( nativeValue, text );
+      return Value( text );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // converts typed args into native args, stopping at the first arg that fails to convert
+  template< class Tuple, std::size_t... Is >
+  static bool _ConvertValues( const Value* values, unsigned long valueCount, Tuple& args, unsigned long& converted, std::index_sequence< Is... > )
+  {
+    static const Value missing;
+    return ( ( _FromValue( Is < valueCount ? values[Is] : missing, std::get< Is >( args ) ) && ( ++converted, true ) ) && ... );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Cl, class Rt, class... Args >
+  static void _Invoke_Method( Cl* object, Rt ( Cl::*methPtr )( Args... ), const Value* values, unsigned long valueCount, Value& result,
+                              const char* methodName )
+  {
+    _ProfileCall<> profile( methodName );
+    std::tuple< typename std::decay< Args >::type... > args;
+    unsigned long converted = 0;
+
+    if( !_ConvertValues( values, valueCount, args, converted, std::index_sequence_for< Args... >() ) )
+    {
+      result = Value::MakeError( _InvalidParamError( converted ) );
+      return;
+    }
+
+    profile.Lap( ProfileConvert );
+
+    if constexpr( std::is_void< Rt >::value )
+    {
+      _Apply( object, methPtr, args, std::index_sequence_for< Args... >() );
+      profile.Lap( ProfileMethod );
+      result = Value();
+    }
+    else
+    {
+      Rt returned = _Apply( object, methPtr, args, std::index_sequence_for< Args... >() );
+      profile.Lap( ProfileMethod );
+      result = _ToValue< typename std::decay< Rt >::type >( returned );
+      profile.Lap( ProfileConvert );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  class _PreparedCall
+  {
+  public:
+    virtual ~_PreparedCall() {}
+
+    virtual _PreparedCall* Clone() const = 0;
+    virtual void BindArg( unsigned long argIndex, const std::string& value ) = 0;
+    virtual std::string Call() = 0;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  template< class Cl, class Rt, class... Args >
+  class _PreparedMethod : public _PreparedCall
+  {
+  public:
+    _PreparedMethod( Cl* object, Rt ( Cl::*methPtr )( Args... ), const _ParamList& params )
+      : _object( object ),
+        _methPtr( methPtr ),
+        _invalidArgs( sizeof...( Args ), false )
+    {
+      _ConvertArgs( params, std::index_sequence_for< Args... >() );
+    }
+
+    _PreparedCall* Clone() const
+    {
+      return new _PreparedMethod( *this );
+    }
+
+    void BindArg( unsigned long argIndex, const std::string& value )
+    {
+      _BindArg( argIndex, value, std::index_sequence_for< Args... >() );
+    }
+
+    std::string Call()
+    {
+      for( unsigned long i = 0; i < _invalidArgs.size(); ++i )
+      {
+        if( _invalidArgs[i] )
+        {
+          return _InvalidParamError( i );
+        }
+      }
+
+      std::string result;
+      _ApplyToString( _object, _methPtr, _args, result );
+      return result;
+    }
+
+  private:
+    // converts constant params; placeholders keep their default value until bound
+    template< std::size_t... Is >
+    void _ConvertArgs( const _ParamList& params, std::index_sequence< Is... > )
+    {
+      ( void ) std::initializer_list< int >{ ( _invalidArgs[Is] =
+        !params.IsPlaceholder( Is ) && !_ConvertParam( params, Is, std::get< Is >( _args ) ), 0 )... };
+    }
+
+    template< std::size_t... Is >
+    void _BindArg( unsigned long argIndex, const std::string& value, std::index_sequence< Is... > )
+    {
+      ( void ) std::initializer_list< int >{ ( argIndex == Is ?
+        ( _invalidArgs[Is] = !ConvertValue( std::string_view( value ), std::get< Is >( _args ) ), 0 ) : 0 )... };
+    }
+
+    Cl* _object;
+    Rt ( Cl::*_methPtr )( Args... );
+    std::tuple< typename std::decay< Args >::type... > _args;
+    std::vector< bool > _invalidArgs;
+  };
+
+  template< class Cl, class Rt, class... Args >
+  static _PreparedCall* _Prepare_Method( Cl* object, Rt ( Cl::*methPtr )( Args... ), const _ParamList& params )
+  {
+    return new _PreparedMethod< Cl, Rt, Args... >( object, methPtr, params );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // The thunks of a field declared by INTERPP_REGISTER_FIELD. Called without a param, a field is
+  // read; called with one, the param is written to it and the result is empty.
+  template< class Cl, class Type, Type Cl::* field >
+  struct _Field
+  {
+    static bool Call( void* object, const _ParamList& params, std::string& result )
+    {
+      if( params.IsBlank() )
+      {
+        ValueConverter< Type >::ToString( ( ( Cl* ) object )->*field, result );
+        return true;
+      }
+
+      Type value;
+
+      if( params.Size() > 1 || !_ConvertParam( params, 0, value ) )
+      {
+        result += _InvalidParamError( params.Size() > 1 ? 1 : 0 );
+        return false;
+      }
+
+      ( ( Cl* ) object )->*field = std::move( value );
+      return true;
+    }
+
+    static _PreparedCall* Prepare( void* object, const _ParamList& params )
+    {
+      return new _Prepared( ( Cl* ) object, params );
+    }
+
+    static void Invoke( void* object, const Value* args, unsigned long argCount, Value& result )
+    {
+      if( argCount == 0 )
+      {
+        result = _ToValue< Type >( ( ( Cl* ) object )->*field );
+        return;
+      }
+
+      Type value;
+
+      if( argCount > 1 || !_FromValue( args[0], value ) )
+      {
+        result = Value::MakeError( _InvalidParamError( argCount > 1 ? 1 : 0 ) );
+        return;
+      }
+
+      ( ( Cl* ) object )->*field = std::move( value );
+      result = Value();
+    }
+
+    // appends the field as the obj.* snapshot shows it: strings quoted, anything else as read
+    static void Append( void* object, std::string& text )
+    {
+      if constexpr( std::is_same< Type, std::string >::value || std::is_same< Type, std::string_view >::value )
+      {
+        _AppendQuoted( ( ( Cl* ) object )->*field, text );
+      }
+      else
+      {
+        ValueConverter< Type >::ToString( ( ( Cl* ) object )->*field, text );
+      }
+    }
+
+  private:
+    // a read, or a write of a constant or placeholder value
+    class _Prepared : public _PreparedCall
+    {
+    public:
+      _Prepared( Cl* object, const _ParamList& params )
+        : _object( object ),
+          _write( !params.IsBlank() ),
+          _invalid( params.Size() > 1 ),
+          _value()
+      {
+        if( _write && !_invalid && !params.IsPlaceholder( 0 ) )
+        {
+          _invalid = !_ConvertParam( params, 0, _value );
+        }
+      }
+
+      _PreparedCall* Clone() const
+      {
+        return new _Prepared( *this );
+      }
+
+      void BindArg( unsigned long argIndex, const std::string& value )
+      {
+        if( argIndex == 0 )
+        {
+          _invalid = !ConvertValue( std::string_view( value ), _value );
+        }
+      }
+
+      std::string Call()
+      {
+        std::string result;
+
+        if( _invalid )
+        {
+          result = _InvalidParamError( 0 );
+        }
+        else if( _write )
+        {
+          _object->*field = _value;
+        }
+        else
+        {
+          ValueConverter< Type >::ToString( _object->*field, result );
+        }
+
+        return result;
+      }
+
+    private:
+      Cl* _object;
+      bool _write;
+      bool _invalid;
+      Type _value;
+    };
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // the fields of a class, in the order declared, and the bases whose fields its snapshot includes
+  struct _FieldNode
+  {
+    const char* fieldName;
+    void (*append)( void*, std::string& );
+    _FieldNode* next;
+  };
+
+  struct _BaseFieldsNode
+  {
+    _interppUpcast upcast;
+    _interppMethod snapshot;
+    _BaseFieldsNode* next;
+  };
+
+  // Serves "object.*": every field of Class and of its bases (see INTERPP_REGISTER_BASE) as
+  // name=value pairs separated by ", ", in one pass. Nodes are linked in as their translation units
+  // are initialized; the snapshot method registers itself with the first of them.
+  template< class Class >
+  struct _FieldList
+  {
+    static bool Add( _FieldNode* node )
+    {
+      *_last = node;
+      _last = &node->next;
+      return _Register();
+    }
+
+    static bool AddBase( _BaseFieldsNode* node )
+    {
+      *_lastBase = node;
+      _lastBase = &node->next;
+      return _Register();
+    }
+
+    static bool Snapshot( void* object, const _ParamList& params, std::string& result )
+    {
+      if( !params.IsBlank() )
+      {
+        result += _InvalidParamError( 0 );
+        return false;
+      }
+
+      std::size_t start = result.size();
+
+      for( const _FieldNode* node = _first; node != NULL; node = node->next )
+      {
+        if( result.size() != start )
+        {
+          result += ", ";
+        }
+
+        result += node->fieldName;
+        result += '=';
+        node->append( object, result );
+      }
+
+      for( const _BaseFieldsNode* node = _firstBase; node != NULL; node = node->next )
+      {
+        std::size_t mark = result.size();
+
+        if( mark != start )
+        {
+          result += ", ";
+        }
+
+        std::size_t baseStart = result.size();
+        node->snapshot( node->upcast( object ), params, result );
+
+        // a base without fields leaves no separator behind
+        if( result.size() == baseStart )
+        {
+          result.resize( mark );
+        }
+      }
+
+      return true;
+    }
+
+    static _PreparedCall* Prepare( void* object, const _ParamList& )
+    {
+      return new _PreparedSnapshot( object );
+    }
+
+    static void Invoke( void* object, const Value*, unsigned long argCount, Value& result )
+    {
+      std::string text;
+
+      if( argCount != 0 )
+      {
+        result = Value::MakeError( _InvalidParamError( 0 ) );
+        return;
+      }
+
+      Snapshot( object, _ParamList( std::string_view() ), text );
+      result = Value( text );
+    }
+
+  private:
+    class _PreparedSnapshot : public _PreparedCall
+    {
+    public:
+      explicit _PreparedSnapshot( void* object )
+        : _object( object ) {}
+
+      _PreparedCall* Clone() const
+      {
+        return new _PreparedSnapshot( *this );
+      }
+
+      void BindArg( unsigned long, const std::string& ) {}
+
+      std::string Call()
+      {
+        std::string result;
+        Snapshot( _object, _ParamList( std::string_view() ), result );
+        return result;
+      }
+
+    private:
+      void* _object;
+    };
+
+    static bool _Register()
+    {
+      if( !_registered )
+      {
+        _registered = true;
+        _RegisterMethodNode( &_node );
+      }
+
+      return true;
+    }
+
+    static inline _FieldNode* _first = NULL;
+    static inline _FieldNode** _last = &_first;
+    static inline _BaseFieldsNode* _firstBase = NULL;
+    static inline _BaseFieldsNode** _lastBase = &_firstBase;
+    static inline bool _registered = false;
+    static inline _MethodNode _node = _MethodNode( typeid( Class ), "*", _ConstHashName( "*" ), { Snapshot, Prepare, Invoke, 0 } );
+  };
+
+  // Memoized results of Pure methods are kept in a bounded LRU cache, sharded to keep threads apart.
+  // Failed calls are not cached.
+  struct MemoStats
+  {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long entries;
+  };
+
+  MemoStats GetMemoStats();
+
+  // sets the most results kept (4096 by default); 0 turns memoization off
+  void SetMemoCapacity( unsigned long entryCount );
+
+  // drops the results memoized for object's methods; call it whenever the object's state changes
+  void InvalidateMemo( const void* object );
+  void ClearMemo();
+
+  // call and invoke, answered from the memo cache when the same call has already succeeded
+  bool _CallMemoized( _interppMethod call, void* object, const _ParamList& params, std::string& result );
+  void _InvokeMemoized( _interppInvoke invoke, void* object, const Value* args, unsigned long argCount, Value& result );
+
+  //-------------------------------------------------------------------------------------------------
+
+  static bool _CallMethod( void* object, const _InterppMethodInfo& method, const _ParamList& params, std::string& result )
+  {
+    if( method.flags & Pure )
+    {
+      return _CallMemoized( method.call, object, params, result );
+    }
+
+    return method.call( object, params, result );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // A command resolved once by Compile() and executed any number of times after. The object and
+  // method are looked up at compile time, and constant params are converted up front. Params
+  // written as an unquoted ? are placeholders, bound in order of appearance via Bind(). Once a
+  // registration has been published, Execute() checks that the object is still registered under its
+  // name, and returns "Error: object not found" while it is not.
+  class CompiledCommand
+  {
+  public:
+    explicit CompiledCommand( std::string error = "Error: method not found" )
+      : _call( NULL ),
+        _error( error ),
+        _registry( NULL ),
+        _epoch( 0 ),
+        _object( NULL ),
+        _typeId( 0 ) {}
+
+    // object and typeId are the object as registered under objectName in registry when epoch was
+    // current, which call was prepared for
+    CompiledCommand( _PreparedCall* call, std::vector< unsigned long >& placeholders, _Registry& registry, unsigned long long epoch,
+                     std::string_view objectName, void* object, unsigned int typeId )
+      : _call( call ),
+        _placeholders( placeholders ),
+        _registry( &registry ),
+        _epoch( epoch ),
+        _objectName( objectName ),
+        _object( object ),
+        _typeId( typeId ) {}
+
+    CompiledCommand( const CompiledCommand& other )
+      : _call( other._call ? other._call->Clone() : NULL ),
+        _error( other._error ),
+        _placeholders( other._placeholders ),
+        _registry( other._registry ),
+        _epoch( other._epoch ),
+        _objectName( other._objectName ),
+        _object( other._object ),
+        _typeId( other._typeId ) {}
+
+    CompiledCommand& operator=( const CompiledCommand& other )
+    {
+      if( this != &other )
+      {
+        delete _call;
+        _call = other._call ? other._call->Clone() : NULL;
+        _error = other._error;
+        _placeholders = other._placeholders;
+        _registry = other._registry;
+        _epoch = other._epoch;
+        _objectName = other._objectName;
+        _object = other._object;
+        _typeId = other._typeId;
+      }
+
+      return *this;
+    }
+
+    ~CompiledCommand()
+    {
+      delete _call;
+    }
+
+    bool IsValid() const
+    {
+      return _call != NULL;
+    }
+
+    unsigned long PlaceholderCount() const
+    {
+      return _placeholders.size();
+    }
+
+    void Bind( unsigned long placeholder, const std::string& value )
+    {
+      if( _call && placeholder < _placeholders.size() )
+      {
+        _call->BindArg( _placeholders[placeholder], value );
+      }
+    }
+
+    std::string Execute()
+    {
+      if( _call == NULL )
+      {
+        return _error;
       }
-      // FromType is double
-      else if( typeid( FromType ) == typeid( double ) )
+
+      if( _epoch != _RegistryEpoch( *_registry ) && !_Revalidate() )
       {
-        returnStream << *reinterpret_cast< double* >( &fromValue );
+        return "Error: object not found";
       }
-      // FromType is float
-      else if( typeid( FromType ) == typeid( float ) )
+
+      return _call->Call();
+    }
+
+  private:
+    // true, taking the current epoch, if the object compiled for is still registered under its name
+    bool _Revalidate()
+    {
+      unsigned long long epoch = _RegistryEpoch( *_registry );
+      unsigned int typeId = 0;
+
+      if( _InterppRegistry::GetObject( _objectName, typeId, *_registry ) != _object || typeId != _typeId )
       {
-        returnStream << *reinterpret_cast< float* >( &fromValue );
+        return false;
       }
-      // FromType is int
-      else if( typeid( FromType ) == typeid( int ) )
+
+      _epoch = epoch;
+      return true;
+    }
+
+    _PreparedCall* _call;
+    std::string _error;
+    std::vector< unsigned long > _placeholders;
+
+    _Registry* _registry;
+    unsigned long long _epoch;
+    std::string _objectName;
+    void* _object;
+    unsigned int _typeId;
+  };
+
+  //=================================================================================================
+
+  static std::string_view _TrimSpaces( std::string_view text )
+  {
+    std::size_t start = text.find_first_not_of( ' ' );
+
+    if( start == std::string_view::npos )
+    {
+      return std::string_view();
+    }
+
+    return text.substr( start, text.find_last_not_of( ' ' ) - start + 1 );
+  }
+
+  // Splits a field access, "field" or "field = value", with its '=' (if any) at assignPos, into the
+  // field's name and the value it is written as a param. Returns false if there is no name, or
+  // nothing after the '='.
+  static bool _SplitField( std::string_view access, std::size_t assignPos, std::string_view& fieldName, std::string_view& value )
+  {
+    if( assignPos == std::string_view::npos )
+    {
+      fieldName = _TrimSpaces( access );
+      value = std::string_view();
+      return !fieldName.empty();
+    }
+
+    fieldName = _TrimSpaces( access.substr( 0, assignPos ) );
+    value = _TrimSpaces( access.substr( assignPos + 1 ) );
+
+    if( value.empty() )
+    {
+      fieldName = std::string_view();
+    }
+
+    return !fieldName.empty();
+  }
+
+  // Splits "object.Method( params )" into views of command; nothing is copied. Returns whether the
+  // command has all of its '.', '(' and ')'. Field accesses, "object.field" and "object.field =
+  // value", split as "object.field()" and "object.field( value )" would.
+  static bool _SplitCommand( std::string_view command, std::string_view& objectName, std::string_view& methodName, std::string_view& params )
+  {
+    std::size_t findPos = 0;
+    std::size_t lastFindPos = 0;
+    bool found = true;
+
+    // get object name
+    findPos = command.find( '.', lastFindPos );
+
+    if( findPos != std::string_view::npos )
+    {
+      objectName = command.substr( 0, findPos );
+    }
+    else
+    {
+      found = false;
+    }
+
+    lastFindPos = findPos + 1;
+
+    // get method name; a '=' before any '(' makes a field write, and neither a field read
+    findPos = command.find_first_of( "(=", lastFindPos );
+
+    if( found && ( findPos == std::string_view::npos || command[findPos] == '=' ) )
+    {
+      return _SplitField( command.substr( lastFindPos ), findPos == std::string_view::npos ? findPos : findPos - lastFindPos,
+                          methodName, params );
+    }
+
+    if( findPos != std::string_view::npos )
+    {
+      methodName = command.substr( lastFindPos, findPos - lastFindPos );
+    }
+    else
+    {
+      found = false;
+    }
+
+    lastFindPos = findPos + 1;
+
+    // get params
+    findPos = command.find( ')', lastFindPos );
+
+    if( findPos != std::string_view::npos )
+    {
+      params = command.substr( lastFindPos, findPos - lastFindPos );
+
+      // params that hold parens of their own (see _CallBroadcast()) run to the last ')'
+      if( params.find( '(' ) != std::string_view::npos )
       {
-        returnStream << *reinterpret_cast< int* >( &fromValue );
+        params = command.substr( lastFindPos, command.rfind( ')' ) - lastFindPos );
       }
-      // FromType is short
-      else if( typeid( FromType ) == typeid( short ) )
+    }
+    else
+    {
+      found = false;
+    }
+
+    return found;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Calls a method for params that hold parens. An argument written range( start, end ) or
+  // range( start, end, step ) (end excluded, as in Python), or each( [a, b, c] ), makes the call a
+  // broadcast: the method is called once per element, with the other arguments the same each time,
+  // and the results are appended as a list, e.g. simple.Multiply( range( 0, 4 ), 2 ) gives
+  // [0, 2, 4, 6]. Broadcast arguments must have as many elements as one another. Constants and
+  // elements convert to the method's param types as the same text would in a plain call. The method
+  // is resolved and the arguments are parsed once, and each call goes through the method's typed
+  // thunk, bypassing the memo cache. Without a broadcast argument (e.g. a string holding
+  // parens), this is a plain call. Returns false having appended the first error.
+  bool _CallBroadcast( void* object, const _InterppMethodInfo& method, std::string_view params, std::string& result );
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Execute() on the objects of registry
+  static std::string _Execute( _Registry& registry, std::string_view command )
+  {
+    _ArenaScope arena;
+    _PhaseTimer<> timer;
+    std::string_view objectName;
+    std::string_view methodName;
+    std::string_view params;
+
+    _SplitCommand( command, objectName, methodName, params );
+    timer.Lap( ProfileSplit );
+
+    // get object and method from registry
+    void* object = NULL;
+    _InterppMethodInfo method = _InterppRegistry::GetMethod( objectName, methodName, &object, registry );
+    timer.Lap( ProfileLookup );
+
+    // execute method
+    if( method.call != NULL )
+    {
+      std::string result;
+
+      if( params.find( '(' ) != std::string_view::npos )
       {
-        returnStream << *reinterpret_cast< short* >( &fromValue );
+        _CallBroadcast( object, method, params, result );
+        return result;
       }
-      // FromType is long
-      else if( typeid( FromType ) == typeid( long ) )
+
+      _ParamList paramList( params );
+      timer.Lap( ProfileParse );
+
+      _CallMethod( object, method, paramList, result );
+      return result;
+    }
+    else if( object == NULL )
+    {
+      return "Error: object not found";
+    }
+    else
+    {
+      return "Error: method not found";
+    }
+  }
+
+  static std::string Execute( std::string_view command )
+  {
+    return _Execute( _DefaultRegistry(), command );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // How a call made by the Execute() overloads below went
+  enum ExecuteStatus
+  {
+    ExecuteOk,
+    ExecuteParseError,       // the command is not of the form object.Method( params )
+    ExecuteObjectNotFound,
+    ExecuteMethodNotFound,
+    ExecuteInvalidParam,     // a param could not be converted to the method's param type
+    ExecuteBufferTooSmall    // the result did not fit the caller's buffer
+  };
+
+  // a short description of status, such as "object not found"
+  const char* ExecuteStatusText( ExecuteStatus status );
+
+  // the status form of Execute() on the objects of registry
+  static ExecuteStatus _Execute( _Registry& registry, std::string_view command, std::string& result )
+  {
+    _ArenaScope arena;
+    _PhaseTimer<> timer;
+    std::string_view objectName;
+    std::string_view methodName;
+    std::string_view params;
+
+    if( !_SplitCommand( command, objectName, methodName, params ) )
+    {
+      return ExecuteParseError;
+    }
+
+    timer.Lap( ProfileSplit );
+
+    void* object = NULL;
+    _InterppMethodInfo method = _InterppRegistry::GetMethod( objectName, methodName, &object, registry );
+    timer.Lap( ProfileLookup );
+
+    if( method.call == NULL )
+    {
+      return object == NULL ? ExecuteObjectNotFound : ExecuteMethodNotFound;
+    }
+
+    // a failed call has appended its error text, so take it back off
+    std::size_t resultSize = result.size();
+
+    if( params.find( '(' ) != std::string_view::npos )
+    {
+      if( !_CallBroadcast( object, method, params, result ) )
       {
-        returnStream << *reinterpret_cast< long* >( &fromValue );
+        result.resize( resultSize );
+        return ExecuteInvalidParam;
       }
-      // FromType is unsigned int
-      else if( typeid( FromType ) == typeid( unsigned int ) )
+
+      return ExecuteOk;
+    }
+
+    _ParamList paramList( params );
+    timer.Lap( ProfileParse );
+
+    if( !_CallMethod( object, method, paramList, result ) )
+    {
+      result.resize( resultSize );
+      return ExecuteInvalidParam;
+    }
+
+    return ExecuteOk;
+  }
+
+  // As Execute() above, but appends the result to result, and reports failures as a status instead
+  // of in-band text: nothing is appended unless the call succeeds. A command missing its '.', '(' or
+  // ')' is not executed. A result string reused across calls keeps its capacity, so steady-state
+  // calls do not allocate.
+  static ExecuteStatus Execute( std::string_view command, std::string& result )
+  {
+    return _Execute( _DefaultRegistry(), command, result );
+  }
+
+  // As above, but writes the result to buffer. size is set to the size of the whole result; if that
+  // is more than capacity, only capacity bytes of it are written and ExecuteBufferTooSmall is
+  // returned, although the method has been called.
+  ExecuteStatus Execute( std::string_view command, char* buffer, std::size_t capacity, std::size_t& size );
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Compile() on the objects of registry
+  static CompiledCommand _Compile( _Registry& registry, std::string_view command )
+  {
+    _ArenaScope arena;
+    std::string_view objectName;
+    std::string_view methodName;
+    std::string_view params;
+
+    _SplitCommand( command, objectName, methodName, params );
+
+    // resolve object and method once; the epoch is taken first, so that a registration published
+    // in between makes Execute() check the object again
+    unsigned long long epoch = _RegistryEpoch( registry );
+    unsigned int typeId = 0;
+    void* registeredObject = _InterppRegistry::GetObject( objectName, typeId, registry );
+    void* object = NULL;
+    _InterppMethodInfo method = _InterppRegistry::GetMethod( objectName, methodName, &object, registry );
+
+    if( object == NULL )
+    {
+      return CompiledCommand( "Error: object not found" );
+    }
+    else if( method.call == NULL )
+    {
+      return CompiledCommand( "Error: method not found" );
+    }
+
+    // convert constant params now, leaving placeholders to be bound at call time
+    _ParamList paramList( params );
+    std::vector< unsigned long > placeholders;
+
+    for( unsigned long i = 0; i < paramList.Size(); ++i )
+    {
+      if( paramList.IsPlaceholder( i ) )
       {
-        returnStream << *reinterpret_cast< unsigned int* >( &fromValue );
+        placeholders.push_back( i );
       }
-      // FromType is unsigned short
-      else if( typeid( FromType ) == typeid( unsigned short ) )
+    }
+
+    return CompiledCommand( method.prepare( object, paramList ), placeholders, registry, epoch, objectName, registeredObject, typeId );
+  }
+
+  static CompiledCommand Compile( std::string_view command )
+  {
+    return _Compile( _DefaultRegistry(), command );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // A method resolved once by Resolve() for typed calls. Arguments go straight from Values to the
+  // method's native params, and the result comes back as a Value, with no text in between.
+  class TypedMethod
+  {
+  public:
+    explicit TypedMethod( const char* error = "Error: method not found" )
+      : _object( NULL ),
+        _invoke( NULL ),
+        _flags( 0 ),
+        _error( error ) {}
+
+    TypedMethod( void* object, _interppInvoke invoke, unsigned int flags = 0 )
+      : _object( object ),
+        _invoke( invoke ),
+        _flags( flags ),
+        _error( NULL ) {}
+
+    bool IsValid() const
+    {
+      return _invoke != NULL;
+    }
+
+    Value Invoke( const Value* args, unsigned long argCount ) const
+    {
+      Value result;
+      Invoke( args, argCount, result );
+      return result;
+    }
+
+    // as above, into result; a memoized result is copied into the text result already holds, so a
+    // caller reusing one Value does not allocate on cache hits
+    void Invoke( const Value* args, unsigned long argCount, Value& result ) const
+    {
+      if( _invoke == NULL )
       {
-        returnStream << *reinterpret_cast< unsigned short* >( &fromValue );
+        result = Value::MakeError( _error );
       }
-      // FromType is unsigned long
-      else if( typeid( FromType ) == typeid( unsigned long ) )
+      else if( _flags & Pure )
       {
-        returnStream << *reinterpret_cast< unsigned long* >( &fromValue );
+        _InvokeMemoized( _invoke, _object, args, argCount, result );
       }
-      // FromType is bool
-      else if( typeid( FromType ) == typeid( bool ) )
+      else
       {
-        returnStream << ( *reinterpret_cast< bool* >( &fromValue ) ? "true" : "false" );
+        _invoke( _object, args, argCount, result );
       }
+    }
 
-      std::string returnValue = returnStream.str();
-      return *reinterpret_cast< ToType* >( &returnValue );
+    Value Invoke( std::initializer_list< Value > args = {} ) const
+    {
+      return Invoke( args.begin(), args.size() );
     }
 
-    return ToType();
-  }
+  private:
+    void* _object;
+    _interppInvoke _invoke;
+    unsigned int _flags;
+    const char* _error;
+  };
 
   //-------------------------------------------------------------------------------------------------
 
-  template< class Cl, class Rt >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )(), _ParamList params )
+  static TypedMethod _ResolvedMethod( void* object, const _InterppMethodInfo& method )
   {
-    return ( object->*methPtr )();
-  }
+    if( object == NULL )
+    {
+      return TypedMethod( "Error: object not found" );
+    }
+    else if( method.invoke == NULL )
+    {
+      return TypedMethod( "Error: method not found" );
+    }
 
-  template< class Cl, class Rt, class T1 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1 ), _ParamList params )
-  {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ) );
+    return TypedMethod( object, method.invoke, method.flags );
   }
 
-  template< class Cl, class Rt, class T1, class T2 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2 ), _ParamList params )
-  {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ) );
-  }
+  //-------------------------------------------------------------------------------------------------
 
-  template< class Cl, class Rt, class T1, class T2, class T3 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3 ), _ParamList params )
+  static TypedMethod Resolve( std::string_view objectName, std::string_view methodName )
   {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ) );
+    void* object = NULL;
+    _InterppMethodInfo method = _InterppRegistry::GetMethod( objectName, methodName, &object );
+    return _ResolvedMethod( object, method );
   }
 
-  template< class Cl, class Rt, class T1, class T2, class T3, class T4 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3, T4 ), _ParamList params )
-  {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ),
-                                 ConvertValue< T4 >( params[3] ) );
-  }
+  //-------------------------------------------------------------------------------------------------
 
-  template< class Cl, class Rt, class T1, class T2, class T3, class T4, class T5 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3, T4, T5 ), _ParamList params )
+  static TypedMethod Resolve( ObjectHandle handle, std::string_view methodName )
   {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ),
-                                 ConvertValue< T4 >( params[3] ),
-                                 ConvertValue< T5 >( params[4] ) );
+    void* object = NULL;
+    _InterppMethodInfo method = _InterppRegistry::GetMethod( handle, methodName, &object );
+    return _ResolvedMethod( object, method );
   }
 
-  template< class Cl, class Rt, class T1, class T2, class T3, class T4, class T5, class T6 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3, T4, T5, T6 ), _ParamList params )
+  //-------------------------------------------------------------------------------------------------
+
+  // e.g. Interpp::Invoke( "simple", "Multiply", { 2.0f, 5.0f } ).AsReal()
+  static Value Invoke( std::string_view objectName, std::string_view methodName, std::initializer_list< Value > args = {} )
   {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ),
-                                 ConvertValue< T4 >( params[3] ),
-                                 ConvertValue< T5 >( params[4] ),
-                                 ConvertValue< T6 >( params[5] ) );
+    return Resolve( objectName, methodName ).Invoke( args );
   }
 
-  template< class Cl, class Rt, class T1, class T2, class T3, class T4, class T5, class T6, class T7 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3, T4, T5, T6, T7 ), _ParamList params )
+  static Value Invoke( ObjectHandle handle, std::string_view methodName, std::initializer_list< Value > args = {} )
   {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ),
-                                 ConvertValue< T4 >( params[3] ),
-                                 ConvertValue< T5 >( params[4] ),
-                                 ConvertValue< T6 >( params[5] ),
-                                 ConvertValue< T7 >( params[6] ) );
+    return Resolve( handle, methodName ).Invoke( args );
   }
 
-  template< class Cl, class Rt, class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3, T4, T5, T6, T7, T8 ), _ParamList params )
+  //-------------------------------------------------------------------------------------------------
+
+  // A registry of objects of its own, and the calls made on them. Methods, fields and bases are
+  // registered per type and shared by every interpreter, but each one has its own object names and
+  // handles, published and looked up apart from any other's: registering in one neither copies nor
+  // locks another's objects, and its objects cannot be reached through another. Give each worker
+  // thread or tenant its own so that their registrations do not contend, nor invalidate one another's
+  // cached resolutions. The free functions work on Default(); its members below are their
+  // counterparts for this interpreter, and CallSite, CompileScript(), ExecuteAwaitable,
+  // ParallelExecutor, StreamRunner and BytecodeProgram take the interpreter to work on, Default()
+  // unless given. An interpreter must outlive the calls made through it, and the methods resolved
+  // from it.
+  class BatchResults;
+
+  class Interpreter
   {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ),
-                                 ConvertValue< T4 >( params[3] ),
-                                 ConvertValue< T5 >( params[4] ),
-                                 ConvertValue< T6 >( params[5] ),
-                                 ConvertValue< T7 >( params[6] ),
-                                 ConvertValue< T8 >( params[7] ) );
-  }
+  public:
+    Interpreter();
+    ~Interpreter();
+
+    // the interpreter the free functions work on
+    static Interpreter& Default();
+
+    template< class Type >
+    ObjectHandle RegisterObject( Type& object, const std::string& objectName )
+    {
+      return _InterppRegistry::AddObject< Type >( ( void* ) &object, objectName, *_registry );
+    }
+
+    template< class Type >
+    ObjectHandle RegisterObject( Type* object, const std::string& objectName )
+    {
+      return _InterppRegistry::AddObject< Type >( ( void* ) object, objectName, *_registry );
+    }
+
+    bool UnregisterObject( std::string_view objectName );
+    bool UnregisterObject( ObjectHandle handle );
+
+    std::string Execute( std::string_view command )
+    {
+      return _Execute( *_registry, command );
+    }
+
+    ExecuteStatus Execute( std::string_view command, std::string& result )
+    {
+      return _Execute( *_registry, command, result );
+    }
+
+    ExecuteStatus Execute( std::string_view command, char* buffer, std::size_t capacity, std::size_t& size );
+
+    CompiledCommand Compile( std::string_view command )
+    {
+      return _Compile( *_registry, command );
+    }
+
+    TypedMethod Resolve( std::string_view objectName, std::string_view methodName )
+    {
+      void* object = NULL;
+      _InterppMethodInfo method = _InterppRegistry::GetMethod( objectName, methodName, &object, *_registry );
+      return _ResolvedMethod( object, method );
+    }
+
+    TypedMethod Resolve( ObjectHandle handle, std::string_view methodName )
+    {
+      void* object = NULL;
+      _InterppMethodInfo method = _InterppRegistry::GetMethod( handle, methodName, &object, *_registry );
+      return _ResolvedMethod( object, method );
+    }
+
+    Value Invoke( std::string_view objectName, std::string_view methodName, std::initializer_list< Value > args = {} )
+    {
+      return Resolve( objectName, methodName ).Invoke( args );
+    }
+
+    Value Invoke( ObjectHandle handle, std::string_view methodName, std::initializer_list< Value > args = {} )
+    {
+      return Resolve( handle, methodName ).Invoke( args );
+    }
+
+    std::future< std::string > ExecuteAsync( std::string_view command );
+
+    void ExecuteBatch( const std::string_view* commands, unsigned long commandCount, BatchResults& results );
+    void ExecuteBatch( const std::string* commands, unsigned long commandCount, BatchResults& results );
+    void ExecuteBatch( std::string_view commandLines, BatchResults& results );
+
+    _Registry& _GetRegistry() const
+    {
+      return *_registry;
+    }
+
+  private:
+    Interpreter( const Interpreter& );
+    Interpreter& operator =( const Interpreter& );
+
+    explicit Interpreter( _Registry* registry );
+
+    _Registry* _registry;
+    bool _ownsRegistry;
+  };
 
-  template< class Cl, class Rt, class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3, T4, T5, T6, T7, T8, T9 ), _ParamList params )
+  //-------------------------------------------------------------------------------------------------
+
+  struct InlineCacheStats
   {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ),
-                                 ConvertValue< T4 >( params[3] ),
-                                 ConvertValue< T5 >( params[4] ),
-                                 ConvertValue< T6 >( params[5] ),
-                                 ConvertValue< T7 >( params[6] ),
-                                 ConvertValue< T8 >( params[7] ),
-                                 ConvertValue< T9 >( params[8] ) );
-  }
+    unsigned long long hits;
+    unsigned long long misses;
+  };
 
-  template< class Cl, class Rt, class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8, class T9, class T10 >
-  static Rt _Call_Method( Cl* object, Rt ( Cl::*methPtr )( T1, T2, T3, T4, T5, T6, T7, T8, T9, T10 ), _ParamList params )
+  //-------------------------------------------------------------------------------------------------
+
+  // A typed call of objectName.methodName that follows the interpreter's registry, where a
+  // TypedMethod is bound once. The resolution is cached inline: while no registration has been
+  // published there (or in the default interpreter, which holds the types), calls go straight to the
+  // method. After one, the object is looked up again by name, and the method only if the site has
+  // not seen that object (of that type) among the last four it resolved. Such a call, or one that
+  // finds the object or method missing, counts as a miss. A CallSite must not be used from two
+  // threads at once.
+  class CallSite
   {
-    return ( object->*methPtr )( ConvertValue< T1 >( params[0] ),
-                                 ConvertValue< T2 >( params[1] ),
-                                 ConvertValue< T3 >( params[2] ),
-                                 ConvertValue< T4 >( params[3] ),
-                                 ConvertValue< T5 >( params[4] ),
-                                 ConvertValue< T6 >( params[5] ),
-                                 ConvertValue< T7 >( params[6] ),
-                                 ConvertValue< T8 >( params[7] ),
-                                 ConvertValue< T9 >( params[8] ),
-                                 ConvertValue< T10 >( params[9] ) );
-  }
+  public:
+    CallSite( std::string_view objectName, std::string_view methodName, Interpreter& interpreter = Interpreter::Default() )
+      : _objectName( objectName ),
+        _methodName( methodName ),
+        _registry( &interpreter._GetRegistry() ),
+        _epoch( 0 ),
+        _usedEntries( 0 ),
+        _nextEntry( 0 ),
+        _stats() {}
+
+    Value Invoke( const Value* args, unsigned long argCount )
+    {
+      if( _epoch != _RegistryEpoch( *_registry ) )
+      {
+        _Rebind();
+      }
+      else
+      {
+        _stats.hits++;
+      }
 
-  //=================================================================================================
+      return _method.Invoke( args, argCount );
+    }
+
+    Value Invoke( std::initializer_list< Value > args = {} )
+    {
+      return Invoke( args.begin(), args.size() );
+    }
+
+    const InlineCacheStats& Stats() const
+    {
+      return _stats;
+    }
+
+  private:
+    struct _Entry
+    {
+      void* object;
+      unsigned int typeId;
+      TypedMethod method;
+    };
+
+    static const unsigned int _size = 4;
+
+    void _Rebind();
+
+    std::string _objectName;
+    std::string _methodName;
+    _Registry* _registry;
+    unsigned long long _epoch;
+    TypedMethod _method;
+    _Entry _entries[_size];
+    unsigned int _usedEntries;
+    unsigned int _nextEntry;
+    InlineCacheStats _stats;
+  };
+
+  //-------------------------------------------------------------------------------------------------
 
-  static std::string Execute( std::string command )
+  // Results of ExecuteBatch(), one per command, packed into a single text buffer. Reuse one
+  // BatchResults across batches so that its buffers are allocated once and then only grow.
+  class BatchResults
   {
-    std::string objectName;
-    std::string methodName;
-    std::string params;
+  public:
+    BatchResults()
+    {
+      _offsets.push_back( 0 );
+    }
 
-    unsigned long findPos = 0;
-    unsigned long lastFindPos = 0;
+    unsigned long Size() const
+    {
+      return _offsets.size() - 1;
+    }
 
-    // get object name
-    findPos = command.find( ".", lastFindPos );
+    std::string_view operator []( unsigned long i ) const
+    {
+      return std::string_view( _text ).substr( _offsets[i], _offsets[i + 1] - _offsets[i] );
+    }
 
-    if( findPos != std::string::npos )
+    // all results back to back: result i is Text()[Offsets()[i], Offsets()[i + 1])
+    const std::string& Text() const
     {
-      objectName = command.substr( 0, findPos );
+      return _text;
     }
 
-    lastFindPos = findPos + 1;
+    const std::vector< std::size_t >& Offsets() const
+    {
+      return _offsets;
+    }
 
-    // get method name
-    findPos = command.find( "(", lastFindPos );
+    void Clear()
+    {
+      _text.clear();
+      _offsets.resize( 1 );
+    }
 
-    if( findPos != std::string::npos )
+    void Reserve( unsigned long resultCount, unsigned long textSize )
     {
-      methodName = command.substr( lastFindPos, findPos - lastFindPos );
+      _offsets.reserve( resultCount + 1 );
+      _text.reserve( textSize );
     }
 
-    lastFindPos = findPos + 1;
+    // used by ExecuteBatch() to append a result
+    std::string& _Text()
+    {
+      return _text;
+    }
 
-    // get params
-    findPos = command.find( ")", lastFindPos );
+    void _EndResult()
+    {
+      _offsets.push_back( _text.size() );
+    }
+
+  private:
+    std::string _text;
+    std::vector< std::size_t > _offsets;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Executes each command as Execute() would, writing the results into results (cleared first).
+  // Each distinct object.Method target is resolved once per batch, so changes to the registry made
+  // during a batch may not be seen until the next one.
+  void ExecuteBatch( const std::string_view* commands, unsigned long commandCount, BatchResults& results );
+  void ExecuteBatch( const std::string* commands, unsigned long commandCount, BatchResults& results );
+
+  // as above, for a buffer of newline-delimited commands (one result per non-blank line)
+  void ExecuteBatch( std::string_view commandLines, BatchResults& results );
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Executes batches like ExecuteBatch(), spread over a pool of worker threads that live as long as
+  // the executor. Commands on the same object run one after another in submission order; commands on
+  // different objects may run concurrently, so their methods must not share unsynchronized state.
+  // Results are returned in input order. An executor runs one batch at a time. With one thread, or
+  // a batch on one object, the batch runs on the calling thread as ExecuteBatch() would run it.
+  class ParallelExecutor
+  {
+  public:
+    // threadCount includes the calling thread, which works on each batch too; 0 uses one thread per
+    // hardware thread. Commands run on the objects of interpreter.
+    explicit ParallelExecutor( unsigned int threadCount = 0, Interpreter& interpreter = Interpreter::Default() );
+    ~ParallelExecutor();
+
+    unsigned int ThreadCount() const;
+
+    void ExecuteBatch( const std::string_view* commands, unsigned long commandCount, BatchResults& results );
+    void ExecuteBatch( const std::string* commands, unsigned long commandCount, BatchResults& results );
+
+    // Executes one command as Execute() would, except that a broadcast (see _CallBroadcast()) is
+    // split into ranges of elements run on the pool. The method is then called on the same object
+    // from several threads at once, so it must be safe to.
+    std::string Execute( std::string_view command );
+
+  private:
+    ParallelExecutor( const ParallelExecutor& );
+    ParallelExecutor& operator =( const ParallelExecutor& );
+
+    class _State;
+    _State* _state;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Receives the output of a StreamRunner, a buffer at a time
+  class StreamSink
+  {
+  public:
+    virtual ~StreamSink() {}
+
+    // returns false if the data could not be written
+    virtual bool Write( const char* data, std::size_t size ) = 0;
+  };
+
+  // writes to a file descriptor, such as 1 for stdout
+  class FdSink : public StreamSink
+  {
+  public:
+    explicit FdSink( int fd )
+      : _fd( fd ) {}
+
+    bool Write( const char* data, std::size_t size );
+
+  private:
+    int _fd;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Executes a stream of newline-delimited commands as ExecuteBatch() would, writing each result
+  // followed by a newline to a sink. Commands are split on a thread owned by the runner while the
+  // calling thread runs the ones already split, so methods are only called from the calling thread.
+  // Lines are not copied into strings: they are views of blockSize blocks of input, of which a few
+  // are in flight at once, so memory stays bounded however long the stream is (a line longer than a
+  // block grows its block to fit). Output is written whenever blockSize bytes of it are buffered,
+  // and when the stream ends. Each Run*() returns false if its input could not be read or its output
+  // could not be written; every command read is still executed. A runner runs one stream at a time.
+  class StreamRunner
+  {
+  public:
+    // commands run on the objects of interpreter
+    explicit StreamRunner( StreamSink& sink, std::size_t blockSize = 64 * 1024, Interpreter& interpreter = Interpreter::Default() );
+    ~StreamRunner();
+
+    // reads fd, which may be a file, pipe or socket, until end of file. Each block is handed over
+    // as soon as it holds a whole line, so commands from a pipe run as they arrive.
+    bool Run( int fd );
+
+    // runs commands already in memory
+    bool Run( std::string_view commandLines );
+
+    // maps the file at path into memory and runs it in place, or reads it where it cannot be mapped
+    bool RunFile( const char* path );
+
+    // the number of commands executed by this runner so far
+    unsigned long long CommandCount() const;
+
+  private:
+    StreamRunner( const StreamRunner& );
+    StreamRunner& operator =( const StreamRunner& );
+
+    class _State;
+    _State* _state;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Runs ExecuteAsync() calls off the calling thread
+  class AsyncExecutor
+  {
+  public:
+    virtual ~AsyncExecutor() {}
+
+    virtual void Post( std::function< void() > task ) = 0;
+  };
+
+  // Replaces the executor used for long-running methods; NULL restores the default, a pool of at least
+  // 4 threads (more on machines with more hardware threads). An executor must outlive the calls it
+  // was given.
+  void SetAsyncExecutor( AsyncExecutor* executor );
+
+  // Looks command up in registry. If it targets a method registered as LongRunning, posts the call to
+  // the async executor and returns false; done( error ) is then called on the executor's thread once
+  // result is written, with any exception the method threw. Otherwise executes command now, as
+  // Execute() would, stores any exception the method threw in error and returns true.
+  bool _ExecuteOrPost( _Registry& registry, std::string_view command, std::string& result, std::exception_ptr& error,
+                       std::function< void( std::exception_ptr ) > done );
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Executes command as Execute() would. Calls to LongRunning methods run on the async executor, so
+  // that they do not hold up the caller; others run now and return a ready future. Either way an
+  // exception the method throws is stored in the future rather than thrown here.
+  std::future< std::string > ExecuteAsync( std::string_view command );
+
+  //-------------------------------------------------------------------------------------------------
 
-    if( findPos != std::string::npos )
+#if defined( __cpp_impl_coroutine ) && __has_include( <coroutine> )
+
+  // co_await ExecuteAwaitable( command ) executes command as ExecuteAsync() does, resuming the
+  // coroutine on the async executor's thread if the call was offloaded. The command runs on the
+  // objects of interpreter.
+  class ExecuteAwaitable
+  {
+  public:
+    explicit ExecuteAwaitable( std::string_view command, Interpreter& interpreter = Interpreter::Default() )
+      : _command( command ),
+        _registry( &interpreter._GetRegistry() ) {}
+
+    bool await_ready() const
     {
-      params = command.substr( lastFindPos, findPos - lastFindPos );
+      return false;
     }
 
-    // get method from registry
-    _interppMethod method = _InterppRegistry::GetMethod( objectName, methodName );
+    bool await_suspend( std::coroutine_handle<> handle )
+    {
+      // once posted the call may complete and resume the coroutine at any time, so this must not be
+      // touched after _ExecuteOrPost() returns false
+      return !_ExecuteOrPost( *_registry, _command, _result, _error, [this, handle]( std::exception_ptr error )
+      {
+        _error = error;
+        handle.resume();
+      } );
+    }
 
-    // execute method
-    if( method != NULL )
+    std::string await_resume()
     {
-      return method( objectName, params );
+      if( _error )
+      {
+        std::rethrow_exception( _error );
+      }
+
+      return std::move( _result );
     }
-    else
+
+  private:
+    std::string _command;
+    _Registry* _registry;
+    std::string _result;
+    std::exception_ptr _error;
+  };
+
+#endif
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Script bytecode: each instruction works on registers a, b and c (variables first, then
+  // temporaries), except where a field holds a constant, call or instruction index
+  enum _ScriptOp
+  {
+    _OpLoadConst,     // a = constants[b]
+    _OpMove,          // a = b
+    _OpAdd,           // a = b + c, and so on for the other binary operators
+    _OpSubtract,
+    _OpMultiply,
+    _OpDivide,
+    _OpModulo,
+    _OpEqual,
+    _OpNotEqual,
+    _OpLess,
+    _OpLessEqual,
+    _OpGreater,
+    _OpGreaterEqual,
+    _OpNegate,        // a = -b
+    _OpNot,           // a = !b
+    _OpToBool,        // a = b converted to Bool
+    _OpJump,          // continue at instruction b
+    _OpJumpIfFalse,   // continue at instruction b if a is false
+    _OpJumpIfTrue,    // continue at instruction b if a is true
+    _OpCall,          // a = calls[b]( c, c + 1, ... )
+    _OpResult         // the script's result is a
+  };
+
+  struct _ScriptInstruction
+  {
+    unsigned short op;
+    unsigned short a;
+    unsigned short b;
+    unsigned short c;
+  };
+
+  struct _ScriptCall
+  {
+    CallSite site;
+    unsigned short argCount;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // A multi-statement script compiled by CompileScript() into bytecode for a register machine. Values
+  // stay typed from one statement to the next, and method calls go straight to the typed thunks (see
+  // Invoke()). Variables keep their values from one run to the next, so a Script must not be run from
+  // two threads at once.
+  class Script
+  {
+  public:
+    Script()
+      : _registerCount( 0 ) {}
+
+    // false if the script failed to compile (see GetError())
+    bool IsValid() const
     {
-      return "Error: method not found";
+      return _error.empty();
     }
-  }
+
+    const std::string& GetError() const
+    {
+      return _error;
+    }
+
+    // Runs the script, returning the value of the last expression statement run, or the first Error
+    // (a failed call, or an operation on values of the wrong type)
+    Value Run();
+
+    // variables are accessible whether or not the script has run; both return false if the script
+    // has no variable by that name
+    bool SetVariable( std::string_view name, const Value& value );
+    bool GetVariable( std::string_view name, Value& value ) const;
+
+    // the inline cache counters of all the script's call sites, summed
+    InlineCacheStats CallStats() const;
+
+  private:
+    friend class _ScriptCompiler;
+    friend Script CompileScript( std::string_view source, Interpreter& interpreter );
+
+    std::vector< _ScriptInstruction > _code;
+    std::vector< unsigned int > _lines;
+    std::vector< Value > _constants;
+    std::vector< _ScriptCall > _calls;
+    std::vector< std::string > _variables;
+    std::vector< Value > _registers;
+    unsigned short _registerCount;
+    std::string _error;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Compiles a script of statements separated by newlines or semicolons:
+  //
+  //   name = expression
+  //   expression
+  //   if condition { ... } else if condition { ... } else { ... }
+  //   while condition { ... }
+  //
+  // Expressions combine literals ( 42, 1.5, 'text', true, false ), variables and object.Method( args )
+  // calls with + - * / % == != < <= > >= && || ! and parentheses. Any other name is a variable, which
+  // starts out Void. // starts a comment. Calls are made on the objects of interpreter.
+  Script CompileScript( std::string_view source, Interpreter& interpreter = Interpreter::Default() );
 
   //-------------------------------------------------------------------------------------------------
 
+  // Returns the object's handle. Registering another object under a taken name replaces it, and
+  // the replaced object's handle no longer finds anything.
   template< class Type >
-  static void RegisterObject( Type& object, std::string objectName )
+  static ObjectHandle RegisterObject( Type& object, std::string objectName )
   {
-    _InterppRegistry::AddObject< Type >( ( void* ) &object, objectName );
+    return _InterppRegistry::AddObject< Type >( ( void* ) &object, objectName );
   }
 
   //-------------------------------------------------------------------------------------------------
 
   template< class Type >
-  static void RegisterObject( Type* object, std::string objectName )
+  static ObjectHandle RegisterObject( Type* object, std::string objectName )
   {
-    _InterppRegistry::AddObject< Type >( ( void* ) object, objectName );
+    return _InterppRegistry::AddObject< Type >( ( void* ) object, objectName );
   }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Removes an object from the registry, frees its slot for reuse and drops its memoized results.
+  // Returns false if it was not registered. Calls already running on the object, and commands
+  // compiled or methods resolved before, still hold it, so destroy it only once they are done.
+  bool UnregisterObject( std::string_view objectName );
+  bool UnregisterObject( ObjectHandle handle );
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Compiles newline-delimited commands, as ExecuteBatch() takes them, into bytecode that a
+  // BytecodeProgram loads without parsing any command text: object and method names go into a symbol
+  // table, and each param is stored as the text Execute() would convert (unescaped if quoted, as
+  // written if not). Blank lines are skipped. Returns false, with error naming the line, if a line
+  // is not a command or is a broadcast (see _CallBroadcast()). Bytecode is versioned and in the
+  // compiling machine's byte order. The interppc tool compiles a command file this way.
+  bool CompileBytecode( std::string_view commandLines, std::string& bytecode, std::string& error );
+
+  // Bytecode compiled by CompileBytecode(), linked against an interpreter's registry: each distinct
+  // object.Method is resolved at load, and again at the start of a run if a registration has been
+  // published since, so a run calls the objects registered under its names when it starts. Running
+  // the program takes each command's params straight from the bytecode and calls its method through
+  // its typed thunk, which converts them as Execute() would, bypassing the memo cache.
+  class BytecodeProgram
+  {
+  public:
+    BytecodeProgram();
+    ~BytecodeProgram();
+
+    // Maps the file at path (or reads it, where it cannot be mapped), checks it is bytecode of this
+    // version and byte order, and links it; the mapping is held until the next load, and runs read
+    // params from it. Returns false, with error set and the program unchanged, if the file cannot be
+    // read or is not valid. A command whose object or method is not registered still loads, and
+    // reports the error as its result.
+    bool Load( const char* path, std::string& error, Interpreter& interpreter = Interpreter::Default() );
+
+    // as Load(), for bytecode already in memory, which must outlive the program's runs
+    bool Load( std::string_view bytecode, std::string& error, Interpreter& interpreter = Interpreter::Default() );
+
+    unsigned long CommandCount() const;
+
+    // runs every command in order, writing one result per command into results (cleared first), as
+    // ExecuteBatch() would
+    void Run( BatchResults& results );
+
+  private:
+    BytecodeProgram( const BytecodeProgram& );
+    BytecodeProgram& operator =( const BytecodeProgram& );
+
+    class _State;
+    _State* _state;
+  };
 }
 
 //=================================================================================================
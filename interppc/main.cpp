@@ -0,0 +1,50 @@
+#include <Interpp.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+//=================================================================================================
+
+// Usage: interppc <command file> <bytecode file>
+// Compiles a file of newline-delimited commands into bytecode for Interpp::BytecodeProgram. Objects
+// and methods are only looked up when the bytecode is loaded, so nothing needs to be registered here.
+int main( int argc, char* argv[] )
+{
+  if( argc != 3 )
+  {
+    std::cerr << "usage: interppc <command file> <bytecode file>\n";
+    return 2;
+  }
+
+  std::ifstream input( argv[1], std::ios::binary );
+
+  if( !input )
+  {
+    std::cerr << "interppc: could not open " << argv[1] << '\n';
+    return 1;
+  }
+
+  std::ostringstream commandLines;
+  commandLines << input.rdbuf();
+
+  std::string bytecode;
+  std::string error;
+
+  if( !Interpp::CompileBytecode( commandLines.str(), bytecode, error ) )
+  {
+    std::cerr << "interppc: " << argv[1] << ": " << error << '\n';
+    return 1;
+  }
+
+  std::ofstream output( argv[2], std::ios::binary | std::ios::trunc );
+
+  if( !output.write( bytecode.data(), bytecode.size() ) )
+  {
+    std::cerr << "interppc: could not write " << argv[2] << '\n';
+    return 1;
+  }
+
+  return 0;
+}
+
+//=================================================================================================
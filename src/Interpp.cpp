@@ -31,15 +31,5379 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <Interpp.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if defined( _WIN32 )
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#include <emmintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+#endif
+
 //=================================================================================================
 
 namespace Interpp
 {
-  std::map< std::string, std::pair< std::string, void* > > _InterppRegistry::_interppObjects;
-  std::map< std::string, std::pair< std::string, void* > >::const_iterator _InterppRegistry::_interppObjectsIt;
+  namespace
+  {
+    // One record per reading thread. epoch is the global epoch observed on entering a read, or 0
+    // while the thread is not reading. Records are recycled when threads exit and never freed.
+    struct alignas( 64 ) _ReaderRecord
+    {
+      std::atomic< unsigned long long > epoch;
+      std::atomic< bool > inUse;
+      _ReaderRecord* next;
+    };
+
+    std::atomic< _ReaderRecord* > _readerRecords( NULL );
+    std::atomic< unsigned long long > _globalEpoch( 1 );
+
+    //-------------------------------------------------------------------------------------------------
+
+    struct _RetiredSnapshot
+    {
+      const _RegistrySnapshot* snapshot;
+      unsigned long long epoch;
+    };
+
+    // writer-side state, only touched under mutex
+    struct _RegistryWriter
+    {
+      std::mutex mutex;
+      std::deque< std::string > symbolNames;
+      std::vector< _RetiredSnapshot > retired;
+    };
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Every registry shares the epoch and the reader records, so a reader in any of them holds back the
+  // freeing of every registry's snapshots, but each publishes on its own, and counts its publications
+  // for the caches that resolve through it (see _RegistryEpoch()).
+  struct _Registry
+  {
+    _Registry()
+      : current( NULL ),
+        published( 0 ) {}
+
+    std::atomic< const _RegistrySnapshot* > current;
+    std::atomic< unsigned long long > published;
+    _RegistryWriter writer;
+  };
+
+  _Registry& _DefaultRegistry()
+  {
+    // constructed on first use so that registration from static initializers is safe
+    static _Registry registry;
+    return registry;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+
+    _ReaderRecord* _AcquireReaderRecord()
+    {
+      // reuse a record released by an exited thread
+      for( _ReaderRecord* record = _readerRecords.load(); record != NULL; record = record->next )
+      {
+        bool expected = false;
+
+        if( !record->inUse.load( std::memory_order_relaxed ) &&
+            record->inUse.compare_exchange_strong( expected, true ) )
+        {
+          return record;
+        }
+      }
+
+      _ReaderRecord* record = new _ReaderRecord();
+      record->epoch.store( 0 );
+      record->inUse.store( true );
+      record->next = _readerRecords.load();
+
+      while( !_readerRecords.compare_exchange_weak( record->next, record ) )
+      {
+      }
+
+      return record;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    struct _ThreadReader
+    {
+      ~_ThreadReader()
+      {
+        if( record != NULL )
+        {
+          record->inUse.store( false, std::memory_order_release );
+        }
+      }
+
+      _ReaderRecord* record;
+      unsigned long depth;
+    };
+
+    thread_local _ThreadReader _threadReader = { NULL, 0 };
+
+    //-------------------------------------------------------------------------------------------------
+
+    // RAII read-side critical section on registry; nested readers share the outermost reader's epoch
+    class _RegistryReader
+    {
+    public:
+      explicit _RegistryReader( const _Registry& registry )
+      {
+        if( _threadReader.depth++ == 0 )
+        {
+          if( _threadReader.record == NULL )
+          {
+            _threadReader.record = _AcquireReaderRecord();
+          }
+
+          // announce the epoch before loading the snapshot, so a writer that swaps it out after
+          // this point will see us and hold off freeing it
+          _threadReader.record->epoch.store( _globalEpoch.load() );
+        }
+
+        _snapshot = registry.current.load();
+      }
+
+      ~_RegistryReader()
+      {
+        if( --_threadReader.depth == 0 )
+        {
+          _threadReader.record->epoch.store( 0, std::memory_order_release );
+        }
+      }
+
+      const _RegistrySnapshot* Get() const
+      {
+        return _snapshot;
+      }
+
+      const _RegistrySnapshot* operator ->() const
+      {
+        return _snapshot;
+      }
+
+      bool IsEmpty() const
+      {
+        return _snapshot == NULL;
+      }
+
+    private:
+      const _RegistrySnapshot* _snapshot;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+
+    // frees retired snapshots that no active reader can still hold
+    void _ReclaimSnapshots( _RegistryWriter& writer )
+    {
+      unsigned long long oldestEpoch = ULLONG_MAX;
+
+      for( _ReaderRecord* record = _readerRecords.load(); record != NULL; record = record->next )
+      {
+        unsigned long long epoch = record->epoch.load();
+
+        if( epoch != 0 && epoch < oldestEpoch )
+        {
+          oldestEpoch = epoch;
+        }
+      }
+
+      unsigned long kept = 0;
+
+      for( unsigned long i = 0; i < writer.retired.size(); ++i )
+      {
+        if( writer.retired[i].epoch < oldestEpoch )
+        {
+          delete writer.retired[i].snapshot;
+        }
+        else
+        {
+          writer.retired[kept++] = writer.retired[i];
+        }
+      }
+
+      writer.retired.resize( kept );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // an open RegistrationBatch: the unpublished snapshot, and the writer lock it holds
+    struct _RegistrationBatchState
+    {
+      _Registry* registry;
+      unsigned long depth;
+      _RegistrySnapshot* snapshot;
+      std::unique_lock< std::mutex > lock;
+
+      // objects unregistered in the batch, whose memoized results are dropped once it is published
+      std::vector< void* > unregistered;
+    };
+
+    // this thread's open batches, one per registry
+    thread_local std::vector< _RegistrationBatchState > _registrationBatches;
+
+    // this thread's open batch on registry, or NULL
+    _RegistrationBatchState* _OpenBatch( const _Registry& registry )
+    {
+      for( unsigned long i = 0; i < _registrationBatches.size(); ++i )
+      {
+        if( _registrationBatches[i].registry == &registry )
+        {
+          return &_registrationBatches[i];
+        }
+      }
+
+      return NULL;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // publishes next in place of registry's current snapshot, whose writer lock the caller holds
+    void _Publish( _Registry& registry, _RegistrySnapshot* next )
+    {
+      _RegistryWriter& writer = registry.writer;
+      const _RegistrySnapshot* current = registry.current.load();
+
+      registry.current.store( next );
+
+      // counted once next is current, so that a cache that reads the count before resolving cannot
+      // record the new count against the old snapshot
+      registry.published.fetch_add( 1 );
+
+      // readers that announced an epoch up to and including this one may still hold current
+      unsigned long long retireEpoch = _globalEpoch.fetch_add( 1 );
+
+      if( current != NULL )
+      {
+        _RetiredSnapshot retired = { current, retireEpoch };
+        writer.retired.push_back( retired );
+      }
+
+      _ReclaimSnapshots( writer );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // copies registry's current snapshot, applies modify() to the copy and publishes it, or applies
+    // it to the copy of the RegistrationBatch open on it
+    template< class Modify >
+    void _PublishSnapshot( _Registry& registry, Modify modify )
+    {
+      _RegistryWriter& writer = registry.writer;
+      _RegistrationBatchState* batch = _OpenBatch( registry );
+
+      if( batch != NULL )
+      {
+        modify( *batch->snapshot, writer.symbolNames );
+        return;
+      }
+
+      std::lock_guard< std::mutex > lock( writer.mutex );
+
+      const _RegistrySnapshot* current = registry.current.load();
+      _RegistrySnapshot* next = current ? new _RegistrySnapshot( *current ) : new _RegistrySnapshot();
+
+      modify( *next, writer.symbolNames );
+      _Publish( registry, next );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    unsigned long long _MethodKey( unsigned int typeId, unsigned int methodId )
+    {
+      return ( ( unsigned long long ) typeId << 32 ) | methodId;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // method nodes that have linked themselves in but are not yet in the registry
+    std::atomic< _MethodNode* > _pendingMethods( NULL );
+
+    // set, under the writer lock, while pending nodes are being added
+    std::atomic< bool > _addingMethods( false );
+
+    void _AddMethodNodes( _RegistrySnapshot& snapshot, std::deque< std::string >& symbolNames, const _MethodNode* nodes )
+    {
+      for( const _MethodNode* node = nodes; node != NULL; node = node->next )
+      {
+        unsigned int typeId = snapshot.symbols.Intern( node->type->name(), symbolNames );
+        unsigned int methodId = snapshot.symbols.Intern( node->methodName, node->methodHash, symbolNames );
+
+        snapshot.methods[ _MethodKey( typeId, methodId ) ] = node->info;
+      }
+    }
+
+    // Adds every pending method node to the registry in one publish. A lookup that finds nothing
+    // pending while another thread is adding nodes waits for it on the writer lock, so it cannot
+    // miss a method that was declared before it started.
+    void _AddPendingMethods()
+    {
+      if( _pendingMethods.load() == NULL && !_addingMethods.load() )
+      {
+        return;
+      }
+
+      _Registry& registry = _DefaultRegistry();
+      _RegistryWriter& writer = registry.writer;
+      _RegistrationBatchState* batch = _OpenBatch( registry );
+      std::unique_lock< std::mutex > lock;
+
+      // an open RegistrationBatch on this thread already holds the writer lock
+      if( batch == NULL )
+      {
+        lock = std::unique_lock< std::mutex >( writer.mutex );
+      }
+
+      _addingMethods.store( true );
+
+      const _MethodNode* nodes = _pendingMethods.exchange( NULL );
+
+      if( nodes != NULL )
+      {
+        // published right away, as a batch only defers the registrations made through it
+        const _RegistrySnapshot* current = registry.current.load();
+        _RegistrySnapshot* next = current ? new _RegistrySnapshot( *current ) : new _RegistrySnapshot();
+
+        _AddMethodNodes( *next, writer.symbolNames, nodes );
+        _Publish( registry, next );
+
+        if( batch != NULL )
+        {
+          _AddMethodNodes( *batch->snapshot, writer.symbolNames, nodes );
+        }
+      }
+
+      _addingMethods.store( false );
+    }
+
+    // the occupied slot handle refers to, or NULL if the handle is stale or was never issued
+    const _ObjectSlot* _FindSlot( const _RegistrySnapshot& snapshot, ObjectHandle handle )
+    {
+      // a zero index wraps around and fails the bounds check
+      unsigned long long index = ( handle & 0xffffffffULL ) - 1;
+
+      if( index >= snapshot.objectSlots.size() )
+      {
+        return NULL;
+      }
+
+      const _ObjectSlot& slot = snapshot.objectSlots[index];
+
+      if( slot.info.object == NULL || slot.generation != ( handle >> 32 ) )
+      {
+        return NULL;
+      }
+
+      return &slot;
+    }
+
+    // objectName is either a registered name or #handle
+    const _ObjectSlot* _FindSlot( const _RegistrySnapshot& snapshot, std::string_view objectName )
+    {
+      if( !objectName.empty() && objectName[0] == '#' )
+      {
+        ObjectHandle handle = 0;
+        const char* end = objectName.data() + objectName.size();
+        std::from_chars_result parsed = std::from_chars( objectName.data() + 1, end, handle );
+
+        if( parsed.ec != std::errc() || parsed.ptr != end )
+        {
+          return NULL;
+        }
+
+        return _FindSlot( snapshot, handle );
+      }
+
+      unsigned int objectId = snapshot.symbols.Find( objectName );
+
+      if( objectId == 0 )
+      {
+        return NULL;
+      }
+
+      const unsigned int* index = snapshot.objects.Find( objectId );
+
+      if( index == NULL )
+      {
+        return NULL;
+      }
+
+      return &snapshot.objectSlots[*index];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // deeper base chains are taken to be cycles, registered by mistake
+    const unsigned long _maxBaseDepth = 16;
+
+    // looks methodId up for typeId, then depth first through its bases, converting object to each
+    // base on the way; object is left as is if the method is not found
+    const _InterppMethodInfo* _FindTypeMethod( const _RegistrySnapshot& snapshot, unsigned int typeId, unsigned int methodId,
+                                               void*& object, unsigned long depth = 0 )
+    {
+      const _InterppMethodInfo* methodInfo = snapshot.methods.Find( _MethodKey( typeId, methodId ) );
+
+      if( methodInfo != NULL || depth == _maxBaseDepth )
+      {
+        return methodInfo;
+      }
+
+      const unsigned int* firstLink = snapshot.bases.Find( typeId );
+
+      for( unsigned int link = firstLink != NULL ? *firstLink + 1 : 0; link != 0; link = snapshot.baseLinks[link - 1].next )
+      {
+        const _BaseLink& base = snapshot.baseLinks[link - 1];
+        void* baseObject = base.upcast( object );
+
+        methodInfo = _FindTypeMethod( snapshot, base.baseTypeId, methodId, baseObject, depth + 1 );
+
+        if( methodInfo != NULL )
+        {
+          object = baseObject;
+          return methodInfo;
+        }
+      }
+
+      return NULL;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // returns a zeroed _InterppMethodInfo if slot is NULL or its type has no such method
+    _InterppMethodInfo _FindMethod( const _RegistrySnapshot& snapshot, const _ObjectSlot* slot, std::string_view methodName, void** object,
+                                    void** registeredObject = NULL )
+    {
+      _InterppMethodInfo notFound = { NULL, NULL, NULL, 0 };
+
+      if( slot == NULL )
+      {
+        return notFound;
+      }
+
+      if( registeredObject != NULL )
+      {
+        *registeredObject = slot->info.object;
+      }
+
+      void* target = slot->info.object;
+      unsigned int methodId = snapshot.symbols.Find( methodName );
+      const _InterppMethodInfo* methodInfo = methodId != 0 ? _FindTypeMethod( snapshot, slot->info.typeId, methodId, target ) : NULL;
+
+      if( object != NULL )
+      {
+        *object = target;
+      }
+
+      if( methodInfo == NULL )
+      {
+        return notFound;
+      }
+
+      return *methodInfo;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // takes a free slot, or appends one, for object; returns its handle
+    ObjectHandle _AllocateSlot( _RegistrySnapshot& snapshot, unsigned int nameId, unsigned int typeId, void* object )
+    {
+      unsigned int index;
+
+      if( !snapshot.freeSlots.empty() )
+      {
+        index = snapshot.freeSlots.back();
+        snapshot.freeSlots.pop_back();
+      }
+      else
+      {
+        index = ( unsigned int ) snapshot.objectSlots.size();
+
+        _ObjectSlot slot = { { 0, NULL }, 0, 0 };
+        snapshot.objectSlots.push_back( slot );
+      }
+
+      _ObjectSlot& slot = snapshot.objectSlots[index];
+      slot.info.typeId = typeId;
+      slot.info.object = object;
+      slot.nameId = nameId;
+      snapshot.objects[nameId] = index;
+
+      return ( ( ObjectHandle ) slot.generation << 32 ) | ( index + 1 );
+    }
+
+    // empties the slot and puts it on the free list; handles to it go stale with the new generation
+    void _FreeSlot( _RegistrySnapshot& snapshot, unsigned int index )
+    {
+      _ObjectSlot& slot = snapshot.objectSlots[index];
+      slot.info.object = NULL;
+      slot.generation++;
+      snapshot.freeSlots.push_back( index );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // 64-bit FNV-1a
+    unsigned long long _HashName( std::string_view name, unsigned long long hash = 14695981039346656037ULL )
+    {
+      for( std::size_t i = 0; i < name.size(); ++i )
+      {
+        hash ^= ( unsigned char ) name[i];
+        hash *= 1099511628211ULL;
+      }
+
+      return hash;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // Bump allocator behind _ArenaResource(). Deallocation is a no-op: memory is reclaimed all at
+    // once by Reset(), which keeps the chunks (up to _retainedSize bytes of them) so that the next
+    // call finds them ready.
+    class _CallArena : public std::pmr::memory_resource
+    {
+    public:
+      _CallArena()
+        : depth( 0 ),
+          _chunk( 0 ),
+          _used( 0 ),
+          _totalSize( 0 ) {}
+
+      ~_CallArena()
+      {
+        for( unsigned long i = 0; i < _chunks.size(); ++i )
+        {
+          ::operator delete( _chunks[i].data );
+        }
+      }
+
+      void Reset()
+      {
+        _chunk = 0;
+        _used = 0;
+
+        // one outsized call should not pin its memory to the thread for good
+        while( _totalSize > _retainedSize )
+        {
+          _totalSize -= _chunks.back().size;
+          ::operator delete( _chunks.back().data );
+          _chunks.pop_back();
+        }
+      }
+
+      // the number of _ArenaScopes open on this thread
+      unsigned long depth;
+
+    protected:
+      void* do_allocate( std::size_t size, std::size_t alignment )
+      {
+        while( true )
+        {
+          if( _chunk < _chunks.size() )
+          {
+            const _Chunk& chunk = _chunks[_chunk];
+            std::uintptr_t start = ( ( std::uintptr_t ) chunk.data + _used + alignment - 1 ) & ~( std::uintptr_t ) ( alignment - 1 );
+
+            if( start + size <= ( std::uintptr_t ) chunk.data + chunk.size )
+            {
+              _used = start + size - ( std::uintptr_t ) chunk.data;
+              return ( void* ) start;
+            }
+
+            _chunk++;
+            _used = 0;
+            continue;
+          }
+
+          // each chunk is at least double the last, so a call needs few of them
+          std::size_t chunkSize = std::max( _chunks.empty() ? _firstChunkSize : _chunks.back().size * 2, size + alignment );
+          _Chunk chunk = { ( char* ) ::operator new( chunkSize ), chunkSize };
+
+          _chunks.push_back( chunk );
+          _totalSize += chunkSize;
+        }
+      }
+
+      void do_deallocate( void*, std::size_t, std::size_t ) {}
+
+      bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept
+      {
+        return this == &other;
+      }
+
+    private:
+      struct _Chunk
+      {
+        char* data;
+        std::size_t size;
+      };
+
+      static const std::size_t _firstChunkSize = 16 * 1024;
+      static const std::size_t _retainedSize = 1024 * 1024;
+
+      std::vector< _Chunk > _chunks;
+      unsigned long _chunk;
+      std::size_t _used;
+      std::size_t _totalSize;
+    };
+
+    thread_local _CallArena _callArena;
+
+    //-------------------------------------------------------------------------------------------------
+
+    // Places a Type in the call arena; it is never destroyed, so Type must not own anything
+    template< class Type, class... Args >
+    Type* _NewInArena( Args&... args )
+    {
+      static_assert( std::is_trivially_destructible< Type >::value, "arena objects are not destroyed" );
+      return new( _ArenaResource()->allocate( sizeof( Type ), alignof( Type ) ) ) Type( args... );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // Direct-mapped cache of object.Method resolutions for the duration of one batch. Entries hold
+    // views into the batch's commands, so a cache must not outlive them.
+    class _BatchCache
+    {
+    public:
+      explicit _BatchCache( _Registry& registry = _DefaultRegistry() )
+        : _entries(),
+          _registry( &registry ),
+          _epoch( _RegistryEpoch( registry ) ) {}
+
+      // registeredObject, if given, is set to the object as registered, which an inherited method's
+      // object is converted from
+      _InterppMethodInfo Resolve( std::string_view objectName, std::string_view methodName, void*& object,
+                                  void** registeredObject = NULL )
+      {
+        // a registration published since the last lookup may have removed or replaced objects
+        unsigned long long epoch = _RegistryEpoch( *_registry );
+
+        if( epoch != _epoch )
+        {
+          Clear();
+          _epoch = epoch;
+        }
+
+        _Entry& entry = _entries[ _HashName( methodName, _HashName( objectName ) ) & ( _size - 1 ) ];
+
+        if( !entry.resolved || entry.objectName != objectName || entry.methodName != methodName )
+        {
+          entry.object = NULL;
+          entry.registeredObject = NULL;
+          entry.method = _InterppRegistry::GetMethod( objectName, methodName, &entry.object, *_registry, &entry.registeredObject );
+          entry.objectName = objectName;
+          entry.methodName = methodName;
+          entry.resolved = true;
+        }
+
+        object = entry.object;
+
+        if( registeredObject != NULL )
+        {
+          *registeredObject = entry.registeredObject;
+        }
+
+        return entry.method;
+      }
+
+      // forgets every resolution, as the names they were made for are about to be overwritten
+      void Clear()
+      {
+        for( unsigned long i = 0; i < _size; ++i )
+        {
+          _entries[i].resolved = false;
+        }
+      }
+
+    private:
+      struct _Entry
+      {
+        std::string_view objectName;
+        std::string_view methodName;
+        void* object;
+        void* registeredObject;
+        _InterppMethodInfo method;
+        bool resolved;
+      };
+
+      static const unsigned long _size = 256;
+
+      _Entry _entries[_size];
+      _Registry* _registry;
+      unsigned long long _epoch;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+
+    // appends the result of a resolved call, or the error for a failed resolution, to result
+    void _CallResolved( void* object, const _InterppMethodInfo& method, std::string_view params, std::string& result )
+    {
+      if( method.call != NULL && params.find( '(' ) != std::string_view::npos )
+      {
+        _CallBroadcast( object, method, params, result );
+      }
+      else if( method.call != NULL )
+      {
+        _CallMethod( object, method, _ParamList( params ), result );
+      }
+      else if( object == NULL )
+      {
+        result += "Error: object not found";
+      }
+      else
+      {
+        result += "Error: method not found";
+      }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // param i as the text Execute() would convert: unescaped if it is quoted, and as written if not.
+    // Either way it is a String, which _FromValue() parses with the param's ValueConverter, so that
+    // a constant converts exactly as it does in a command.
+    Value _ParseConstant( const _ParamList& params, unsigned long i )
+    {
+      return params.IsQuoted( i ) ? Value( params.Unescaped( i ) ) : Value( params[i] );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // The arguments of a call made by _CallBroadcast(), parsed once into Values
+    class _Broadcast
+    {
+    public:
+      _Broadcast()
+        : _size( 0 ),
+          _isBroadcast( false ) {}
+
+      // returns false having set error if an argument is not valid
+      bool Parse( std::string_view params, std::string& error )
+      {
+        std::size_t argStart = 0;
+        unsigned long depth = 0;
+        char quote = '\0';
+
+        for( std::size_t i = 0; i <= params.size(); ++i )
+        {
+          char c = i < params.size() ? params[i] : ',';
+
+          if( quote != '\0' )
+          {
+            quote = c == quote && params[i - 1] != '\\' ? '\0' : quote;
+          }
+          else if( c == '\'' || c == '\"' )
+          {
+            quote = c;
+          }
+          else if( c == '(' || c == '[' )
+          {
+            depth++;
+          }
+          else if( ( c == ')' || c == ']' ) && depth != 0 )
+          {
+            depth--;
+          }
+          else if( c == ',' && depth == 0 )
+          {
+            if( !_ParseArg( _TrimSpaces( params.substr( argStart, i - argStart ) ) ) )
+            {
+              error = _lengthsDiffer ? "Error: broadcast lengths differ" : _InvalidParamError( _args.size() - 1 );
+              return false;
+            }
+
+            argStart = i + 1;
+          }
+        }
+
+        return true;
+      }
+
+      // whether an argument is a range or list to call the method for each element of
+      bool IsBroadcast() const
+      {
+        return _isBroadcast;
+      }
+
+      unsigned long long Size() const
+      {
+        return _size;
+      }
+
+      // Calls invoke for elements [begin, end), appending the results, separated by ", ", to text.
+      // Void results are left out. Returns false, with failure set, at the first error.
+      bool Run( void* object, _interppInvoke invoke, unsigned long long begin, unsigned long long end, std::string& text,
+                Value& failure ) const
+      {
+        std::pmr::vector< Value > args( _args.size(), Value(), _ArenaResource() );
+        Value result;
+        std::size_t start = text.size();
+
+        for( unsigned long a = 0; a < _args.size(); ++a )
+        {
+          args[a] = _args[a].value;
+        }
+
+        for( unsigned long long i = begin; i < end; ++i )
+        {
+          for( unsigned long a = 0; a < _args.size(); ++a )
+          {
+            const _Arg& arg = _args[a];
+
+            if( arg.kind == _ArgIntRange )
+            {
+              _AssignNumber( args[a], ( long long ) ( ( unsigned long long ) arg.intStart + i * ( unsigned long long ) arg.intStep ) );
+            }
+            else if( arg.kind == _ArgRealRange )
+            {
+              _AssignNumber( args[a], arg.realStart + i * arg.realStep );
+            }
+            else if( arg.kind == _ArgList )
+            {
+              args[a] = arg.elements[i];
+            }
+          }
+
+          invoke( object, args.data(), args.size(), result );
+
+          if( result.IsError() )
+          {
+            failure = result;
+            return false;
+          }
+
+          if( result.IsVoid() )
+          {
+            continue;
+          }
+
+          if( text.size() != start )
+          {
+            text += ", ";
+          }
+
+          _AppendValue( result, text );
+        }
+
+        return true;
+      }
+
+    private:
+      enum _ArgKind
+      {
+        _ArgConstant,
+        _ArgIntRange,
+        _ArgRealRange,
+        _ArgList
+      };
+
+      struct _Arg
+      {
+        _ArgKind kind;
+        Value value;
+        long long intStart;
+        long long intStep;
+        double realStart;
+        double realStep;
+        std::vector< Value > elements;
+      };
+
+      // Range elements are passed as the text that writes them out exactly, so that they convert as
+      // the same numbers written in a command would
+      template< class Number >
+      static void _AssignNumber( Value& value, Number number )
+      {
+        char buffer[32];
+        std::to_chars_result formatted = std::to_chars( buffer, buffer + sizeof( buffer ), number );
+        value._Assign( std::string_view( buffer, formatted.ptr - buffer ) );
+      }
+
+      // the text inside name( ... ) if arg is written so, or an empty view
+      static std::string_view _Inner( std::string_view arg, std::string_view name )
+      {
+        if( arg.size() < name.size() + 2 || arg.substr( 0, name.size() ) != name || arg.back() != ')' )
+        {
+          return std::string_view();
+        }
+
+        std::string_view rest = arg.substr( name.size() );
+        std::size_t open = rest.find_first_not_of( ' ' );
+
+        if( rest[open] != '(' )
+        {
+          return std::string_view();
+        }
+
+        return rest.substr( open + 1, rest.size() - open - 2 );
+      }
+
+      // reads a range bound or step, as an integer if it is one
+      static bool _ParseBound( std::string_view text, long long& integer, double& real, bool& isReal )
+      {
+        const char* last = text.data() + text.size();
+
+        if( !text.empty() && std::from_chars( text.data(), last, integer ).ptr == last )
+        {
+          real = ( double ) integer;
+          return true;
+        }
+
+        isReal = true;
+        return !text.empty() && std::from_chars( text.data(), last, real ).ptr == last && std::isfinite( real );
+      }
+
+      bool _ParseRange( std::string_view inner, _Arg& arg, unsigned long long& size )
+      {
+        _ParamList bounds( inner );
+        long long integers[3] = { 0, 0, 1 };
+        double reals[3] = { 0.0, 0.0, 1.0 };
+        bool isReal = false;
+
+        if( bounds.Size() < 2 || bounds.Size() > 3 )
+        {
+          return false;
+        }
+
+        for( unsigned long i = 0; i < 3 && i < bounds.Size(); ++i )
+        {
+          if( bounds.IsQuoted( i ) || !_ParseBound( bounds[i], integers[i], reals[i], isReal ) )
+          {
+            return false;
+          }
+        }
+
+        if( !isReal )
+        {
+          long long start = integers[0];
+          long long end = integers[1];
+          long long step = integers[2];
+
+          if( step == 0 )
+          {
+            return false;
+          }
+
+          // counted in unsigned arithmetic, which cannot overflow for any bounds
+          unsigned long long span = step > 0 ? ( end > start ? ( unsigned long long ) end - start : 0 ) :
+                                               ( start > end ? ( unsigned long long ) start - end : 0 );
+          unsigned long long stride = step > 0 ? ( unsigned long long ) step : 0 - ( unsigned long long ) step;
+
+          arg.kind = _ArgIntRange;
+          arg.intStart = start;
+          arg.intStep = step;
+          size = span / stride + ( span % stride != 0 );
+          return true;
+        }
+
+        double count = std::ceil( ( reals[1] - reals[0] ) / reals[2] );
+
+        if( reals[2] == 0.0 || !( count < 1e18 ) )
+        {
+          return false;
+        }
+
+        arg.kind = _ArgRealRange;
+        arg.realStart = reals[0];
+        arg.realStep = reals[2];
+        size = count > 0 ? ( unsigned long long ) count : 0;
+        return true;
+      }
+
+      bool _ParseArg( std::string_view text )
+      {
+        _args.emplace_back();
+        _Arg& arg = _args.back();
+        arg.kind = _ArgConstant;
+
+        std::string_view range = _Inner( text, "range" );
+        std::string_view each = _Inner( text, "each" );
+        unsigned long long size = 0;
+
+        if( range.data() != NULL )
+        {
+          if( !_ParseRange( range, arg, size ) )
+          {
+            return false;
+          }
+        }
+        else if( each.data() != NULL )
+        {
+          each = _TrimSpaces( each );
+
+          if( each.size() < 2 || each.front() != '[' || each.back() != ']' )
+          {
+            return false;
+          }
+
+          std::string_view elements = each.substr( 1, each.size() - 2 );
+          _ParamList list( elements.find_first_not_of( ' ' ) != std::string_view::npos ? elements : std::string_view() );
+
+          for( unsigned long i = 0; i < list.Size(); ++i )
+          {
+            arg.elements.push_back( _ParseConstant( list, i ) );
+          }
+
+          arg.kind = _ArgList;
+          size = arg.elements.size();
+        }
+        else
+        {
+          _ParamList single( text );
+
+          if( single.Size() > 1 )
+          {
+            return false;
+          }
+
+          arg.value = _ParseConstant( single, 0 );
+          return true;
+        }
+
+        _lengthsDiffer = _isBroadcast && size != _size;
+        _size = size;
+        _isBroadcast = true;
+        return !_lengthsDiffer;
+      }
+
+      static void _AppendValue( const Value& value, std::string& text )
+      {
+        switch( value.GetType() )
+        {
+          case Value::Bool:
+            ValueConverter< bool >::ToString( value.AsBool(), text );
+            break;
+          case Value::Int:
+            ValueConverter< long long >::ToString( value.AsInt(), text );
+            break;
+          case Value::Real:
+            ValueConverter< double >::ToString( value.AsReal(), text );
+            break;
+          default:
+            // quoted, so that the result reads back as a list of strings
+            _AppendQuoted( value.AsString(), text );
+            break;
+        }
+      }
+
+      std::vector< _Arg > _args;
+      unsigned long long _size;
+      bool _isBroadcast;
+      bool _lengthsDiffer = false;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+
+    void _ExecuteBatched( std::string_view command, _BatchCache& cache, BatchResults& results )
+    {
+      std::string_view objectName;
+      std::string_view methodName;
+      std::string_view params;
+
+      _SplitCommand( command, objectName, methodName, params );
+
+      void* object = NULL;
+      _InterppMethodInfo method = cache.Resolve( objectName, methodName, object );
+
+      _CallResolved( object, method, params, results._Text() );
+      results._EndResult();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template< class String >
+    void _ExecuteBatch( _Registry& registry, const String* commands, unsigned long commandCount, BatchResults& results )
+    {
+      // the cache is several KB, so keep it off the stack of deeply nested callers
+      _ArenaScope arena;
+      _BatchCache* cache = _NewInArena< _BatchCache >( registry );
+
+      results.Clear();
+      results.Reserve( commandCount, 0 );
+
+      for( unsigned long i = 0; i < commandCount; ++i )
+      {
+        _ExecuteBatched( commands[i], *cache, results );
+      }
+    }
+
+    void _ExecuteLines( _Registry& registry, std::string_view commandLines, BatchResults& results )
+    {
+      _ArenaScope arena;
+      _BatchCache* cache = _NewInArena< _BatchCache >( registry );
+
+      results.Clear();
+
+      while( !commandLines.empty() )
+      {
+        std::size_t lineEnd = commandLines.find( '\n' );
+        std::string_view line = commandLines.substr( 0, lineEnd );
+
+        commandLines.remove_prefix( lineEnd == std::string_view::npos ? commandLines.size() : lineEnd + 1 );
+
+        if( !line.empty() && line.back() == '\r' )
+        {
+          line.remove_suffix( 1 );
+        }
+
+        if( line.find_first_not_of( " \t" ) != std::string_view::npos )
+        {
+          _ExecuteBatched( line, *cache, results );
+        }
+      }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    typedef void ( *_PoolJob )( void* context, unsigned long task );
+
+    // Runs the tasks of one job at a time on a fixed set of threads. Each thread has its own task
+    // queue, working from its back and, once that is empty, stealing from the front of the others.
+    class _WorkStealingPool
+    {
+    public:
+      explicit _WorkStealingPool( unsigned int threadCount )
+        : _queues( threadCount ),
+          _generation( 0 ),
+          _busyWorkers( 0 ),
+          _stopping( false ),
+          _job( NULL ),
+          _context( NULL )
+      {
+        for( unsigned int i = 1; i < threadCount; ++i )
+        {
+          _workers.push_back( std::thread( &_WorkStealingPool::_WorkerMain, this, i ) );
+        }
+      }
+
+      ~_WorkStealingPool()
+      {
+        {
+          std::lock_guard< std::mutex > lock( _mutex );
+          _stopping = true;
+        }
+
+        _wake.notify_all();
+
+        for( unsigned long i = 0; i < _workers.size(); ++i )
+        {
+          _workers[i].join();
+        }
+      }
+
+      unsigned int ThreadCount() const
+      {
+        return _queues.size();
+      }
+
+      // Calls job( context, task ) for each task, on the pool's threads and the calling thread, and
+      // returns once all calls are done. Tasks are dealt out across the queues in order, so list the
+      // largest first.
+      void Run( const unsigned long* tasks, unsigned long taskCount, _PoolJob job, void* context )
+      {
+        for( unsigned long i = 0; i < taskCount; ++i )
+        {
+          _TaskQueue& queue = _queues[i % _queues.size()];
+          std::lock_guard< std::mutex > lock( queue.mutex );
+          queue.tasks.push_back( tasks[i] );
+        }
+
+        {
+          std::lock_guard< std::mutex > lock( _mutex );
+          _job = job;
+          _context = context;
+          _busyWorkers = _workers.size();
+          ++_generation;
+        }
+
+        _wake.notify_all();
+        _Work( 0 );
+
+        std::unique_lock< std::mutex > lock( _mutex );
+        _idle.wait( lock, [this]() { return _busyWorkers == 0; } );
+      }
+
+    private:
+      struct alignas( 64 ) _TaskQueue
+      {
+        std::mutex mutex;
+        std::deque< unsigned long > tasks;
+      };
+
+      void _WorkerMain( unsigned int index )
+      {
+        unsigned long generation = 0;
+
+        while( true )
+        {
+          {
+            std::unique_lock< std::mutex > lock( _mutex );
+            _wake.wait( lock, [&]() { return _stopping || _generation != generation; } );
+
+            if( _stopping )
+            {
+              return;
+            }
+
+            generation = _generation;
+          }
+
+          _Work( index );
+
+          std::lock_guard< std::mutex > lock( _mutex );
+
+          if( --_busyWorkers == 0 )
+          {
+            _idle.notify_one();
+          }
+        }
+      }
+
+      // no tasks are queued while a job runs, so once every queue is empty there is nothing to do
+      void _Work( unsigned int index )
+      {
+        unsigned long task;
+
+        while( _Pop( index, task ) || _Steal( index, task ) )
+        {
+          _job( _context, task );
+        }
+      }
+
+      bool _Pop( unsigned int index, unsigned long& task )
+      {
+        _TaskQueue& queue = _queues[index];
+        std::lock_guard< std::mutex > lock( queue.mutex );
+
+        if( queue.tasks.empty() )
+        {
+          return false;
+        }
+
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+      }
+
+      bool _Steal( unsigned int index, unsigned long& task )
+      {
+        for( unsigned long i = 1; i < _queues.size(); ++i )
+        {
+          _TaskQueue& queue = _queues[( index + i ) % _queues.size()];
+          std::lock_guard< std::mutex > lock( queue.mutex );
+
+          if( !queue.tasks.empty() )
+          {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      std::vector< _TaskQueue > _queues;
+      std::vector< std::thread > _workers;
+
+      std::mutex _mutex;
+      std::condition_variable _wake;
+      std::condition_variable _idle;
+      unsigned long _generation;
+      unsigned long _busyWorkers;
+      bool _stopping;
+
+      _PoolJob _job;
+      void* _context;
+    };
+  }
+
+  //=================================================================================================
+
+  _ArenaScope::_ArenaScope()
+  {
+    _callArena.depth++;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  _ArenaScope::~_ArenaScope()
+  {
+    if( --_callArena.depth == 0 )
+    {
+      _callArena.Reset();
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  std::pmr::memory_resource* _ArenaResource()
+  {
+    if( _callArena.depth != 0 )
+    {
+      return &_callArena;
+    }
+
+    return std::pmr::new_delete_resource();
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    // Lends out a string that keeps its capacity from one call to the next. A method may itself
+    // call Execute(), so each nesting level on a thread has a string of its own.
+    class _ScratchString
+    {
+    public:
+      _ScratchString()
+      {
+        if( _depth == _strings.size() )
+        {
+          _strings.emplace_back( new std::string() );
+        }
+
+        _string = _strings[_depth++].get();
+        _string->clear();
+      }
+
+      ~_ScratchString()
+      {
+        // as with the call arena, one outsized result should not pin its memory to the thread
+        if( _string->capacity() > 1024 * 1024 )
+        {
+          std::string().swap( *_string );
+        }
+
+        _depth--;
+      }
+
+      std::string& Get()
+      {
+        return *_string;
+      }
+
+    private:
+      _ScratchString( const _ScratchString& );
+      _ScratchString& operator =( const _ScratchString& );
+
+      static thread_local std::vector< std::unique_ptr< std::string > > _strings;
+      static thread_local unsigned long _depth;
+
+      std::string* _string;
+    };
+
+    thread_local std::vector< std::unique_ptr< std::string > > _ScratchString::_strings;
+    thread_local unsigned long _ScratchString::_depth = 0;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  const char* ExecuteStatusText( ExecuteStatus status )
+  {
+    switch( status )
+    {
+      case ExecuteOk:
+        return "ok";
+      case ExecuteParseError:
+        return "parse error";
+      case ExecuteObjectNotFound:
+        return "object not found";
+      case ExecuteMethodNotFound:
+        return "method not found";
+      case ExecuteInvalidParam:
+        return "invalid param";
+      case ExecuteBufferTooSmall:
+        return "buffer too small";
+    }
+
+    return "unknown status";
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    // Execute() into a caller's buffer, on the objects of registry
+    ExecuteStatus _ExecuteToBuffer( _Registry& registry, std::string_view command, char* buffer, std::size_t capacity,
+                                    std::size_t& size )
+    {
+      _ScratchString scratch;
+      std::string& result = scratch.Get();
+
+      ExecuteStatus status = _Execute( registry, command, result );
+      size = result.size();
+
+      if( size != 0 && capacity != 0 )
+      {
+        std::memcpy( buffer, result.data(), std::min( size, capacity ) );
+      }
+
+      if( status == ExecuteOk && size > capacity )
+      {
+        return ExecuteBufferTooSmall;
+      }
+
+      return status;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  ExecuteStatus Execute( std::string_view command, char* buffer, std::size_t capacity, std::size_t& size )
+  {
+    return _ExecuteToBuffer( _DefaultRegistry(), command, buffer, capacity, size );
+  }
+
+  //=================================================================================================
+
+  bool _CallBroadcast( void* object, const _InterppMethodInfo& method, std::string_view params, std::string& result )
+  {
+    _Broadcast broadcast;
+    std::string error;
+
+    if( !broadcast.Parse( params, error ) )
+    {
+      result += error;
+      return false;
+    }
+
+    if( !broadcast.IsBroadcast() )
+    {
+      return _CallMethod( object, method, _ParamList( params ), result );
+    }
+
+    std::size_t start = result.size();
+    Value failure;
+    result += '[';
+
+    if( !broadcast.Run( object, method.invoke, 0, broadcast.Size(), result, failure ) )
+    {
+      result.resize( start );
+      result += failure.AsString();
+      return false;
+    }
+
+    result += ']';
+    return true;
+  }
+
+  //=================================================================================================
+
+  void ExecuteBatch( const std::string_view* commands, unsigned long commandCount, BatchResults& results )
+  {
+    _ExecuteBatch( _DefaultRegistry(), commands, commandCount, results );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void ExecuteBatch( const std::string* commands, unsigned long commandCount, BatchResults& results )
+  {
+    _ExecuteBatch( _DefaultRegistry(), commands, commandCount, results );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void ExecuteBatch( std::string_view commandLines, BatchResults& results )
+  {
+    _ExecuteLines( _DefaultRegistry(), commandLines, results );
+  }
+
+  //=================================================================================================
+
+  class ParallelExecutor::_State
+  {
+  public:
+    _State( unsigned int threadCount, _Registry& registry )
+      : _pool( threadCount ),
+        _registry( &registry ),
+        _broadcast( NULL ),
+        _broadcastObject( NULL ),
+        _broadcastInvoke( NULL ),
+        _groupCount( 0 ) {}
+
+    // Commands are grouped by target object, and each group runs as one pool task so that calls on
+    // an object keep their order. Results are written to the group's own buffer, then gathered.
+    // With one thread, or one group, nothing would run alongside, so the batch runs here as
+    // ExecuteBatch() runs it, without the handoff to the pool and the gathering.
+    template< class String >
+    void Execute( const String* batch, unsigned long commandCount, BatchResults& results )
+    {
+      if( ThreadCount() <= 1 )
+      {
+        _ExecuteBatch( *_registry, batch, commandCount, results );
+        return;
+      }
+
+      _ArenaScope arena;
+      _BatchCache* cache = _NewInArena< _BatchCache >( *_registry );
+      std::pmr::unordered_map< void*, unsigned long > groupIds( _ArenaResource() );
+
+      for( unsigned long i = 0; i < _groupCount; ++i )
+      {
+        _groups[i].commands.clear();
+        _groups[i].text.clear();
+      }
+
+      _groupCount = 0;
+      _commands.resize( commandCount );
+
+      for( unsigned long i = 0; i < commandCount; ++i )
+      {
+        std::string_view objectName;
+        std::string_view methodName;
+        _Command& command = _commands[i];
+
+        _SplitCommand( batch[i], objectName, methodName, command.params );
+
+        // grouped by the object as registered, as an inherited method is called on a base of it
+        void* registeredObject = NULL;
+        command.object = NULL;
+        command.method = cache->Resolve( objectName, methodName, command.object, &registeredObject );
+
+        std::pair< std::pmr::unordered_map< void*, unsigned long >::iterator, bool > group =
+            groupIds.insert( std::make_pair( registeredObject, _groupCount ) );
+
+        if( group.second && _groupCount++ == _groups.size() )
+        {
+          _groups.emplace_back();
+        }
+
+        command.group = group.first->second;
+        _groups[command.group].commands.push_back( i );
+      }
+
+      if( _groupCount == 1 )
+      {
+        results.Clear();
+        results.Reserve( commandCount, 0 );
+
+        for( unsigned long i = 0; i < commandCount; ++i )
+        {
+          _CallResolved( _commands[i].object, _commands[i].method, _commands[i].params, results._Text() );
+          results._EndResult();
+        }
+
+        return;
+      }
+
+      _order.resize( _groupCount );
+
+      for( unsigned long i = 0; i < _groupCount; ++i )
+      {
+        _order[i] = i;
+      }
+
+      // largest groups first, ties in first-seen order (std::stable_sort would allocate a buffer)
+      std::sort( _order.begin(), _order.end(), [this]( unsigned long a, unsigned long b )
+      {
+        std::size_t aSize = _groups[a].commands.size();
+        std::size_t bSize = _groups[b].commands.size();
+        return aSize > bSize || ( aSize == bSize && a < b );
+      } );
+
+      _pool.Run( _order.data(), _groupCount, _RunGroup, this );
+
+      std::size_t textSize = 0;
+
+      for( unsigned long i = 0; i < _groupCount; ++i )
+      {
+        textSize += _groups[i].text.size();
+      }
+
+      results.Clear();
+      results.Reserve( commandCount, textSize );
+
+      for( unsigned long i = 0; i < commandCount; ++i )
+      {
+        const _Command& command = _commands[i];
+        results._Text().append( _groups[command.group].text, command.begin, command.end - command.begin );
+        results._EndResult();
+      }
+    }
+
+    // A broadcast is split into chunks of elements, a few per thread so that a slow chunk does not
+    // hold up the rest, each run as one pool task into its own buffer; anything else is executed here.
+    std::string Broadcast( std::string_view command )
+    {
+      _ArenaScope arena;
+      std::string_view objectName;
+      std::string_view methodName;
+      std::string_view params;
+
+      _SplitCommand( command, objectName, methodName, params );
+
+      void* object = NULL;
+      _InterppMethodInfo method = _InterppRegistry::GetMethod( objectName, methodName, &object, *_registry );
+      _Broadcast broadcast;
+      std::string error;
+
+      if( method.call == NULL || params.find( '(' ) == std::string_view::npos || !broadcast.Parse( params, error ) ||
+          !broadcast.IsBroadcast() )
+      {
+        return _Execute( *_registry, command );
+      }
+
+      unsigned long long size = broadcast.Size();
+      unsigned long chunkCount = ( unsigned long ) std::max< unsigned long long >( std::min< unsigned long long >( size, ThreadCount() * 4ull ), 1 );
+
+      _chunks.resize( std::max< std::size_t >( _chunks.size(), chunkCount ) );
+      _order.resize( chunkCount );
+
+      for( unsigned long i = 0; i < chunkCount; ++i )
+      {
+        _chunks[i].begin = size * i / chunkCount;
+        _chunks[i].end = size * ( i + 1 ) / chunkCount;
+        _chunks[i].text.clear();
+        _chunks[i].failed = false;
+        _order[i] = i;
+      }
+
+      _broadcast = &broadcast;
+      _broadcastObject = object;
+      _broadcastInvoke = method.invoke;
+      _pool.Run( _order.data(), chunkCount, _RunChunk, this );
+
+      std::string result = "[";
+
+      for( unsigned long i = 0; i < chunkCount; ++i )
+      {
+        if( _chunks[i].failed )
+        {
+          return _chunks[i].failure.AsString();
+        }
+
+        if( !_chunks[i].text.empty() )
+        {
+          result += result.size() > 1 ? ", " : "";
+          result += _chunks[i].text;
+        }
+      }
+
+      result += ']';
+      return result;
+    }
+
+    unsigned int ThreadCount() const
+    {
+      return _pool.ThreadCount();
+    }
+
+  private:
+    struct _Command
+    {
+      std::string_view params;
+      void* object;
+      _InterppMethodInfo method;
+      unsigned long group;
+      std::size_t begin;
+      std::size_t end;
+    };
+
+    // aligned so that threads filling neighbouring groups do not share cache lines
+    struct alignas( 64 ) _Group
+    {
+      std::vector< unsigned long > commands;
+      std::string text;
+    };
+
+    static void _RunGroup( void* context, unsigned long groupIndex )
+    {
+      _ArenaScope arena;
+      _State* state = ( _State* ) context;
+      _Group& group = state->_groups[groupIndex];
+
+      for( unsigned long i = 0; i < group.commands.size(); ++i )
+      {
+        _Command& command = state->_commands[group.commands[i]];
+
+        command.begin = group.text.size();
+        _CallResolved( command.object, command.method, command.params, group.text );
+        command.end = group.text.size();
+      }
+    }
+
+    struct alignas( 64 ) _Chunk
+    {
+      unsigned long long begin;
+      unsigned long long end;
+      std::string text;
+      Value failure;
+      bool failed;
+    };
+
+    static void _RunChunk( void* context, unsigned long chunkIndex )
+    {
+      _ArenaScope arena;
+      _State* state = ( _State* ) context;
+      _Chunk& chunk = state->_chunks[chunkIndex];
+
+      chunk.failed = !state->_broadcast->Run( state->_broadcastObject, state->_broadcastInvoke, chunk.begin, chunk.end,
+                                              chunk.text, chunk.failure );
+    }
+
+    _WorkStealingPool _pool;
+    _Registry* _registry;
+
+    std::vector< _Chunk > _chunks;
+    const _Broadcast* _broadcast;
+    void* _broadcastObject;
+    _interppInvoke _broadcastInvoke;
+
+    std::vector< _Command > _commands;
+    std::vector< _Group > _groups;
+    unsigned long _groupCount;
+    std::vector< unsigned long > _order;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  ParallelExecutor::ParallelExecutor( unsigned int threadCount, Interpreter& interpreter )
+  {
+    if( threadCount == 0 )
+    {
+      threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+
+    _state = new _State( threadCount, interpreter._GetRegistry() );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  ParallelExecutor::~ParallelExecutor()
+  {
+    delete _state;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned int ParallelExecutor::ThreadCount() const
+  {
+    return _state->ThreadCount();
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void ParallelExecutor::ExecuteBatch( const std::string_view* commands, unsigned long commandCount, BatchResults& results )
+  {
+    _state->Execute( commands, commandCount, results );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void ParallelExecutor::ExecuteBatch( const std::string* commands, unsigned long commandCount, BatchResults& results )
+  {
+    _state->Execute( commands, commandCount, results );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  std::string ParallelExecutor::Execute( std::string_view command )
+  {
+    return _state->Broadcast( command );
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    // read() and write(), retried when interrupted by a signal
+    long _ReadFd( int fd, char* buffer, std::size_t size )
+    {
+#if defined( _WIN32 )
+      return _read( fd, buffer, ( unsigned int ) std::min< std::size_t >( size, INT_MAX ) );
+#else
+      while( true )
+      {
+        ssize_t count = read( fd, buffer, size );
+
+        if( count >= 0 || errno != EINTR )
+        {
+          return ( long ) count;
+        }
+      }
+#endif
+    }
+
+    long _WriteFd( int fd, const char* data, std::size_t size )
+    {
+#if defined( _WIN32 )
+      return _write( fd, data, ( unsigned int ) std::min< std::size_t >( size, INT_MAX ) );
+#else
+      while( true )
+      {
+        ssize_t count = write( fd, data, size );
+
+        if( count >= 0 || errno != EINTR )
+        {
+          return ( long ) count;
+        }
+      }
+#endif
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool FdSink::Write( const char* data, std::size_t size )
+  {
+    while( size > 0 )
+    {
+      long count = _WriteFd( _fd, data, size );
+
+      if( count <= 0 )
+      {
+        return false;
+      }
+
+      data += count;
+      size -= count;
+    }
+
+    return true;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // The splitter thread turns input into blocks of split commands, and the calling thread runs
+  // them. _blockCount blocks circulate between the two: free, then ready, then free again once run.
+  // A NULL in the ready queue marks the end of a stream.
+  class StreamRunner::_State
+  {
+  public:
+    _State( StreamSink& sink, std::size_t blockSize, _Registry& registry )
+      : _sink( sink ),
+        _blockSize( std::max< std::size_t >( blockSize, 1 ) ),
+        _cache( new _BatchCache( registry ) ),
+        _commandCount( 0 ),
+        _inputFd( -1 ),
+        _inputReady( false ),
+        _readFailed( false ),
+        _stopping( false )
+    {
+      for( unsigned long i = 0; i < _blockCount; ++i )
+      {
+        _free.push_back( &_blocks[i] );
+      }
+
+      _output.reserve( _blockSize * 2 );
+      _splitter = std::thread( &_State::_SplitterMain, this );
+    }
+
+    ~_State()
+    {
+      {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _stopping = true;
+      }
+
+      _wake.notify_all();
+      _splitter.join();
+    }
+
+    // runs fd if it is not negative, and commandLines otherwise
+    bool Run( int fd, std::string_view commandLines )
+    {
+      {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _inputFd = fd;
+        _input = commandLines;
+        _inputReady = true;
+      }
+
+      _wake.notify_all();
+
+      bool written = true;
+
+      while( true )
+      {
+        _Block* block = _NextReady();
+
+        if( block == NULL )
+        {
+          break;
+        }
+
+        // the cache holds views of names in the block, which is refilled once released
+        _ArenaScope arena;
+        _cache->Clear();
+
+        for( unsigned long i = 0; i < block->commands.size(); ++i )
+        {
+          const _Command& command = block->commands[i];
+          void* object = NULL;
+          _InterppMethodInfo method = _cache->Resolve( command.objectName, command.methodName, object );
+
+          _CallResolved( object, method, command.params, _output );
+          _output += '\n';
+          _commandCount++;
+
+          if( _output.size() >= _blockSize )
+          {
+            written = _Flush() && written;
+          }
+        }
+
+        _Release( block );
+      }
+
+      written = _Flush() && written;
+
+      std::lock_guard< std::mutex > lock( _mutex );
+      return written && !_readFailed;
+    }
+
+    unsigned long long CommandCount() const
+    {
+      return _commandCount;
+    }
+
+  private:
+    struct _Command
+    {
+      std::string_view objectName;
+      std::string_view methodName;
+      std::string_view params;
+    };
+
+    struct _Block
+    {
+      std::vector< char > buffer;
+      std::vector< _Command > commands;
+    };
+
+    void _SplitterMain()
+    {
+      while( true )
+      {
+        int fd;
+        std::string_view input;
+
+        {
+          std::unique_lock< std::mutex > lock( _mutex );
+          _wake.wait( lock, [this]() { return _stopping || _inputReady; } );
+
+          if( !_inputReady )
+          {
+            return;
+          }
+
+          _inputReady = false;
+          fd = _inputFd;
+          input = _input;
+        }
+
+        bool read = true;
+
+        if( fd >= 0 )
+        {
+          read = _SplitFd( fd );
+        }
+        else
+        {
+          _SplitText( input );
+        }
+
+        {
+          std::lock_guard< std::mutex > lock( _mutex );
+          _readFailed = !read;
+          _ready.push_back( NULL );
+        }
+
+        _wake.notify_all();
+      }
+    }
+
+    // splits text in place, a block's worth of whole lines at a time
+    void _SplitText( std::string_view text )
+    {
+      while( !text.empty() )
+      {
+        std::size_t end = text.size();
+
+        // end the block after the last line that fits, or after the first line if none does
+        if( end > _blockSize )
+        {
+          end = text.rfind( '\n', _blockSize - 1 );
+
+          if( end == std::string_view::npos )
+          {
+            end = text.find( '\n', _blockSize );
+          }
+
+          end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+
+        _Block* block = _Acquire();
+        _SplitLines( text.substr( 0, end ), *block );
+        _Publish( block );
+
+        text.remove_prefix( end );
+      }
+    }
+
+    // Reads fd into blocks. A block is handed over once a read brings in a newline; the partial line
+    // after the last one is carried over to the start of the next block. Returns false if a read
+    // failed.
+    bool _SplitFd( int fd )
+    {
+      bool ended = false;
+      bool read = true;
+
+      _carry.clear();
+
+      while( !ended )
+      {
+        _Block* block = _Acquire();
+        std::vector< char >& buffer = block->buffer;
+
+        if( buffer.size() < std::max( _blockSize, _carry.size() * 2 ) )
+        {
+          buffer.resize( std::max( _blockSize, _carry.size() * 2 ) );
+        }
+
+        std::memcpy( buffer.data(), _carry.data(), _carry.size() );
+
+        std::size_t size = _carry.size();
+        std::size_t linesEnd = std::string_view::npos;
+
+        while( linesEnd == std::string_view::npos )
+        {
+          // a line longer than the block
+          if( size == buffer.size() )
+          {
+            buffer.resize( buffer.size() * 2 );
+          }
+
+          long count = _ReadFd( fd, buffer.data() + size, buffer.size() - size );
+
+          if( count <= 0 )
+          {
+            ended = true;
+            read = count == 0;
+            linesEnd = size;
+            break;
+          }
+
+          linesEnd = std::string_view( buffer.data() + size, count ).rfind( '\n' );
+
+          if( linesEnd != std::string_view::npos )
+          {
+            linesEnd += size + 1;
+          }
+
+          size += count;
+        }
+
+        _carry.assign( buffer.data() + linesEnd, size - linesEnd );
+        _SplitLines( std::string_view( buffer.data(), linesEnd ), *block );
+        _Publish( block );
+      }
+
+      return read;
+    }
+
+    // splits each non-blank line into its object name, method name and params, as ExecuteBatch()
+    // does
+    static void _SplitLines( std::string_view lines, _Block& block )
+    {
+      block.commands.clear();
+
+      while( !lines.empty() )
+      {
+        std::size_t lineEnd = lines.find( '\n' );
+        std::string_view line = lines.substr( 0, lineEnd );
+
+        lines.remove_prefix( lineEnd == std::string_view::npos ? lines.size() : lineEnd + 1 );
+
+        if( !line.empty() && line.back() == '\r' )
+        {
+          line.remove_suffix( 1 );
+        }
+
+        if( line.find_first_not_of( " \t" ) != std::string_view::npos )
+        {
+          _Command command;
+          _SplitCommand( line, command.objectName, command.methodName, command.params );
+          block.commands.push_back( command );
+        }
+      }
+    }
+
+    _Block* _Acquire()
+    {
+      std::unique_lock< std::mutex > lock( _mutex );
+      _wake.wait( lock, [this]() { return !_free.empty(); } );
+
+      _Block* block = _free.back();
+      _free.pop_back();
+      return block;
+    }
+
+    void _Publish( _Block* block )
+    {
+      {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _ready.push_back( block );
+      }
+
+      _wake.notify_all();
+    }
+
+    _Block* _NextReady()
+    {
+      std::unique_lock< std::mutex > lock( _mutex );
+      _wake.wait( lock, [this]() { return !_ready.empty(); } );
+
+      _Block* block = _ready.front();
+      _ready.pop_front();
+      return block;
+    }
+
+    void _Release( _Block* block )
+    {
+      {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _free.push_back( block );
+      }
+
+      _wake.notify_all();
+    }
+
+    bool _Flush()
+    {
+      bool written = _output.empty() || _sink.Write( _output.data(), _output.size() );
+      _output.clear();
+      return written;
+    }
+
+    // enough for the splitter to work on one block while the caller runs another, with one to spare
+    static const unsigned long _blockCount = 3;
+
+    StreamSink& _sink;
+    std::size_t _blockSize;
+    std::unique_ptr< _BatchCache > _cache;
+    std::string _output;
+    unsigned long long _commandCount;
+
+    // used by the splitter thread only
+    std::string _carry;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    _Block _blocks[_blockCount];
+    std::vector< _Block* > _free;
+    std::deque< _Block* > _ready;
+    int _inputFd;
+    std::string_view _input;
+    bool _inputReady;
+    bool _readFailed;
+    bool _stopping;
+    std::thread _splitter;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  StreamRunner::StreamRunner( StreamSink& sink, std::size_t blockSize, Interpreter& interpreter )
+  {
+    _state = new _State( sink, blockSize, interpreter._GetRegistry() );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  StreamRunner::~StreamRunner()
+  {
+    delete _state;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool StreamRunner::Run( int fd )
+  {
+    return fd >= 0 && _state->Run( fd, std::string_view() );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool StreamRunner::Run( std::string_view commandLines )
+  {
+    return _state->Run( -1, commandLines );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool StreamRunner::RunFile( const char* path )
+  {
+#if defined( _WIN32 )
+    int fd = _open( path, _O_RDONLY | _O_BINARY );
+
+    if( fd < 0 )
+    {
+      return false;
+    }
+
+    bool ran = Run( fd );
+    _close( fd );
+    return ran;
+#else
+    int fd = open( path, O_RDONLY );
+
+    if( fd < 0 )
+    {
+      return false;
+    }
+
+    struct stat status;
+    void* mapping = MAP_FAILED;
+
+    if( fstat( fd, &status ) == 0 && S_ISREG( status.st_mode ) && status.st_size > 0 )
+    {
+      mapping = mmap( NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    }
+
+    bool ran;
+
+    // the file must not be truncated while it is mapped
+    if( mapping != MAP_FAILED )
+    {
+      madvise( mapping, status.st_size, MADV_SEQUENTIAL );
+      ran = Run( std::string_view( ( const char* ) mapping, status.st_size ) );
+      munmap( mapping, status.st_size );
+    }
+    else
+    {
+      // empty files, pipes and devices are read instead
+      ran = Run( fd );
+    }
+
+    close( fd );
+    return ran;
+#endif
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned long long StreamRunner::CommandCount() const
+  {
+    return _state->CommandCount();
+  }
+
+  //=================================================================================================
+
+  // HDR-style latency histogram: log-linear buckets, 8 per power of two, so each bucket's bounds are
+  // within 12.5% of one another. Only the owning thread writes; readers may merge at any time.
+  struct _Histogram
+  {
+    static const unsigned long bucketCount = 8 + 61 * 8;
+
+    static unsigned long Bucket( unsigned long long ns )
+    {
+      if( ns < 8 )
+      {
+        return ( unsigned long ) ns;
+      }
+
+      unsigned long exponent = 3;
+
+      while( ( ns >> exponent ) > 1 )
+      {
+        ++exponent;
+      }
+
+      return 8 + ( exponent - 3 ) * 8 + ( unsigned long ) ( ( ns >> ( exponent - 3 ) ) & 7 );
+    }
+
+    // the largest value that falls in bucket
+    static unsigned long long BucketMax( unsigned long bucket )
+    {
+      if( bucket < 8 )
+      {
+        return bucket;
+      }
+
+      unsigned long exponent = ( bucket - 8 ) / 8 + 3;
+      unsigned long long lowest = ( unsigned long long ) ( 8 + ( bucket - 8 ) % 8 ) << ( exponent - 3 );
+      return lowest + ( 1ULL << ( exponent - 3 ) ) - 1;
+    }
+
+    std::atomic< unsigned long long > buckets[bucketCount];
+    std::atomic< unsigned long long > count;
+    std::atomic< unsigned long long > sum;
+    std::atomic< unsigned long long > max;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  struct _MethodProfile
+  {
+    _MethodProfile()
+      : calls( 0 ),
+        phases() {}
+
+    std::atomic< unsigned long long > calls;
+    _Histogram phases[_ProfilePhaseCount];
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    // single-writer increment: cheaper than fetch_add, and readers still see whole values
+    void _Bump( std::atomic< unsigned long long >& counter, unsigned long long amount )
+    {
+      counter.store( counter.load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // One thread's profiles, keyed by method name. Shards outlive their threads, so that a dump still
+    // includes threads that have exited; the mutex only guards the map against concurrent dumps.
+    struct _ProfileShard
+    {
+      std::mutex mutex;
+      std::unordered_map< const char*, std::unique_ptr< _MethodProfile > > methods;
+    };
+
+    struct _ProfileShards
+    {
+      std::mutex mutex;
+      std::vector< std::unique_ptr< _ProfileShard > > shards;
+    };
+
+    _ProfileShards& _AllProfileShards()
+    {
+      static _ProfileShards shards;
+      return shards;
+    }
+
+    _ProfileShard& _ThreadProfileShard()
+    {
+      thread_local _ProfileShard* shard = NULL;
+
+      if( shard == NULL )
+      {
+        _ProfileShards& all = _AllProfileShards();
+        std::lock_guard< std::mutex > lock( all.mutex );
+
+        all.shards.push_back( std::unique_ptr< _ProfileShard >( new _ProfileShard() ) );
+        shard = all.shards.back().get();
+      }
+
+      return *shard;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // a method's profile merged across threads (the same name may also be registered from several
+    // translation units)
+    struct _MergedProfile
+    {
+      _MergedProfile()
+        : calls( 0 ) {}
+
+      struct Phase
+      {
+        Phase()
+          : buckets( _Histogram::bucketCount, 0 ),
+            count( 0 ),
+            sum( 0 ),
+            max( 0 ) {}
+
+        // the upper bound of the bucket holding the given fraction of samples
+        unsigned long long Percentile( double fraction ) const
+        {
+          unsigned long long rank = ( unsigned long long ) ( fraction * count );
+          unsigned long long seen = 0;
+
+          for( unsigned long i = 0; i < buckets.size(); ++i )
+          {
+            seen += buckets[i];
+
+            if( seen > rank )
+            {
+              return std::min( _Histogram::BucketMax( i ), max );
+            }
+          }
+
+          return max;
+        }
+
+        std::vector< unsigned long long > buckets;
+        unsigned long long count;
+        unsigned long long sum;
+        unsigned long long max;
+      };
+
+      unsigned long long calls;
+      Phase phases[_ProfilePhaseCount];
+    };
+
+    const char* const _phaseNames[_ProfilePhaseCount] = { "split", "lookup", "parse", "convert", "method", "total" };
+
+    std::map< std::string, _MergedProfile > _MergeProfiles()
+    {
+      std::map< std::string, _MergedProfile > merged;
+      _ProfileShards& all = _AllProfileShards();
+      std::lock_guard< std::mutex > lock( all.mutex );
+
+      for( unsigned long s = 0; s < all.shards.size(); ++s )
+      {
+        std::lock_guard< std::mutex > shardLock( all.shards[s]->mutex );
+
+        for( auto method = all.shards[s]->methods.begin(); method != all.shards[s]->methods.end(); ++method )
+        {
+          _MergedProfile& profile = merged[method->first];
+          profile.calls += method->second->calls.load( std::memory_order_relaxed );
+
+          for( int p = 0; p < _ProfilePhaseCount; ++p )
+          {
+            const _Histogram& histogram = method->second->phases[p];
+            _MergedProfile::Phase& phase = profile.phases[p];
+
+            for( unsigned long b = 0; b < _Histogram::bucketCount; ++b )
+            {
+              phase.buckets[b] += histogram.buckets[b].load( std::memory_order_relaxed );
+            }
+
+            phase.count += histogram.count.load( std::memory_order_relaxed );
+            phase.sum += histogram.sum.load( std::memory_order_relaxed );
+            phase.max = std::max( phase.max, histogram.max.load( std::memory_order_relaxed ) );
+          }
+        }
+      }
+
+      return merged;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned long long* _ProfilePending()
+  {
+    thread_local unsigned long long pending[_ProfilePhaseCount] = {};
+    return pending;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  _MethodProfile* _ProfileBegin( const char* methodName, unsigned long long& pendingNs )
+  {
+    _ProfileShard& shard = _ThreadProfileShard();
+    auto found = shard.methods.find( methodName );
+
+    if( found == shard.methods.end() )
+    {
+      std::lock_guard< std::mutex > lock( shard.mutex );
+      found = shard.methods.emplace( methodName, std::unique_ptr< _MethodProfile >( new _MethodProfile() ) ).first;
+    }
+
+    _MethodProfile* profile = found->second.get();
+    unsigned long long* pending = _ProfilePending();
+
+    _Bump( profile->calls, 1 );
+    pendingNs = 0;
+
+    for( int i = 0; i < ProfileTotal; ++i )
+    {
+      if( pending[i] != 0 )
+      {
+        _ProfileRecord( profile, ( ProfilePhase ) i, pending[i] );
+        pendingNs += pending[i];
+        pending[i] = 0;
+      }
+    }
+
+    return profile;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void _ProfileRecord( _MethodProfile* profile, ProfilePhase phase, unsigned long long ns )
+  {
+    _Histogram& histogram = profile->phases[phase];
+
+    _Bump( histogram.buckets[_Histogram::Bucket( ns )], 1 );
+    _Bump( histogram.count, 1 );
+    _Bump( histogram.sum, ns );
+
+    if( ns > histogram.max.load( std::memory_order_relaxed ) )
+    {
+      histogram.max.store( ns, std::memory_order_relaxed );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  std::string DumpProfile()
+  {
+    std::map< std::string, _MergedProfile > profiles = _MergeProfiles();
+    std::string text;
+    char line[160];
+
+    for( auto method = profiles.begin(); method != profiles.end(); ++method )
+    {
+      snprintf( line, sizeof( line ), "%s: %llu calls\n", method->first.c_str(), method->second.calls );
+      text += line;
+      snprintf( line, sizeof( line ), "  %-8s %12s %12s %12s %12s %12s %12s\n", "phase", "count", "mean ns", "p50 ns",
+                "p90 ns", "p99 ns", "max ns" );
+      text += line;
+
+      for( int p = 0; p < _ProfilePhaseCount; ++p )
+      {
+        const _MergedProfile::Phase& phase = method->second.phases[p];
+
+        if( phase.count != 0 )
+        {
+          snprintf( line, sizeof( line ), "  %-8s %12llu %12llu %12llu %12llu %12llu %12llu\n", _phaseNames[p], phase.count,
+                    phase.sum / phase.count, phase.Percentile( 0.5 ), phase.Percentile( 0.9 ), phase.Percentile( 0.99 ), phase.max );
+          text += line;
+        }
+      }
+    }
+
+    return text;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  std::string DumpProfileJson()
+  {
+    std::map< std::string, _MergedProfile > profiles = _MergeProfiles();
+    std::string json = "{\"methods\":[";
+    char field[160];
+
+    for( auto method = profiles.begin(); method != profiles.end(); ++method )
+    {
+      // method names are C++ identifiers joined by "::", so they need no escaping
+      json += method == profiles.begin() ? "{" : ",{";
+      snprintf( field, sizeof( field ), "\"name\":\"%s\",\"calls\":%llu,\"phases\":{", method->first.c_str(), method->second.calls );
+      json += field;
+
+      bool first = true;
+
+      for( int p = 0; p < _ProfilePhaseCount; ++p )
+      {
+        const _MergedProfile::Phase& phase = method->second.phases[p];
+
+        if( phase.count != 0 )
+        {
+          snprintf( field, sizeof( field ), "%s\"%s\":{\"count\":%llu,\"mean_ns\":%llu,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu}",
+                    first ? "" : ",", _phaseNames[p], phase.count, phase.sum / phase.count, phase.Percentile( 0.5 ),
+                    phase.Percentile( 0.9 ), phase.Percentile( 0.99 ), phase.max );
+          json += field;
+          first = false;
+        }
+      }
+
+      json += "}}";
+    }
+
+    return json + "]}";
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void ResetProfile()
+  {
+    _ProfileShards& all = _AllProfileShards();
+    std::lock_guard< std::mutex > lock( all.mutex );
+
+    for( unsigned long s = 0; s < all.shards.size(); ++s )
+    {
+      std::lock_guard< std::mutex > shardLock( all.shards[s]->mutex );
+
+      for( auto method = all.shards[s]->methods.begin(); method != all.shards[s]->methods.end(); ++method )
+      {
+        _MethodProfile& profile = *method->second;
+        profile.calls.store( 0, std::memory_order_relaxed );
+
+        for( int p = 0; p < _ProfilePhaseCount; ++p )
+        {
+          for( unsigned long b = 0; b < _Histogram::bucketCount; ++b )
+          {
+            profile.phases[p].buckets[b].store( 0, std::memory_order_relaxed );
+          }
+
+          profile.phases[p].count.store( 0, std::memory_order_relaxed );
+          profile.phases[p].sum.store( 0, std::memory_order_relaxed );
+          profile.phases[p].max.store( 0, std::memory_order_relaxed );
+        }
+      }
+    }
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    struct _MemoEntry
+    {
+      std::string key;
+      const void* object;
+      Value value;
+    };
+
+    // One shard of the memo cache: an LRU list (most recent first) indexed by key
+    struct alignas( 64 ) _MemoShard
+    {
+      _MemoShard()
+        : hits( 0 ),
+          misses( 0 ),
+          evictions( 0 ) {}
+
+      std::mutex mutex;
+      std::list< _MemoEntry > entries;
+      std::unordered_map< std::string_view, std::list< _MemoEntry >::iterator > index;
+      unsigned long long hits;
+      unsigned long long misses;
+      unsigned long long evictions;
+    };
+
+    const unsigned long _memoShardCount = 16;
+
+    _MemoShard _memoShards[_memoShardCount];
+    std::atomic< unsigned long > _memoShardCapacity( 4096 / _memoShardCount );
+
+    //-------------------------------------------------------------------------------------------------
+
+    // Memo keys are the object and thunk addresses followed by the normalized args. Keys are built in
+    // a per-thread buffer, so lookups that hit do not allocate.
+    std::string& _MemoKey( const void* object, const void* thunk )
+    {
+      thread_local std::string key;
+
+      key.assign( ( const char* ) &object, sizeof( object ) );
+      key.append( ( const char* ) &thunk, sizeof( thunk ) );
+      return key;
+    }
+
+    void _AppendKeyPart( std::string& key, std::string_view part )
+    {
+      unsigned long size = part.size();
+      key.append( ( const char* ) &size, sizeof( size ) );
+      key.append( part );
+    }
+
+    _MemoShard& _MemoShardFor( std::string_view key )
+    {
+      return _memoShards[_HashName( key ) % _memoShardCount];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // on a hit, hands the cached value to use( value ) while the shard is still locked, so that callers
+    // can copy out of it without first copying it into a Value of their own
+    template< class Use >
+    bool _MemoFind( std::string_view key, Use use )
+    {
+      _MemoShard& shard = _MemoShardFor( key );
+      std::lock_guard< std::mutex > lock( shard.mutex );
+
+      auto found = shard.index.find( key );
+
+      if( found == shard.index.end() )
+      {
+        ++shard.misses;
+        return false;
+      }
+
+      ++shard.hits;
+      shard.entries.splice( shard.entries.begin(), shard.entries, found->second );
+      use( found->second->value );
+      return true;
+    }
+
+    void _MemoStore( std::string_view key, const void* object, const Value& value )
+    {
+      unsigned long capacity = _memoShardCapacity.load( std::memory_order_relaxed );
+
+      if( capacity == 0 )
+      {
+        return;
+      }
+
+      _MemoShard& shard = _MemoShardFor( key );
+      std::lock_guard< std::mutex > lock( shard.mutex );
+
+      // another thread may have stored the same call meanwhile
+      if( shard.index.find( key ) != shard.index.end() )
+      {
+        return;
+      }
+
+      while( shard.entries.size() >= capacity )
+      {
+        shard.index.erase( shard.entries.back().key );
+        shard.entries.pop_back();
+        ++shard.evictions;
+      }
+
+      shard.entries.push_front( _MemoEntry() );
+      _MemoEntry& entry = shard.entries.front();
+      entry.key = key;
+      entry.object = object;
+      entry.value = value;
+      shard.index[entry.key] = shard.entries.begin();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // removes entries for which remove( entry ) is true from every shard
+    template< class Predicate >
+    void _MemoRemove( Predicate remove )
+    {
+      for( unsigned long i = 0; i < _memoShardCount; ++i )
+      {
+        _MemoShard& shard = _memoShards[i];
+        std::lock_guard< std::mutex > lock( shard.mutex );
+
+        for( std::list< _MemoEntry >::iterator entry = shard.entries.begin(); entry != shard.entries.end(); )
+        {
+          if( remove( *entry ) )
+          {
+            shard.index.erase( entry->key );
+            entry = shard.entries.erase( entry );
+          }
+          else
+          {
+            ++entry;
+          }
+        }
+      }
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool _CallMemoized( _interppMethod call, void* object, const _ParamList& params, std::string& result )
+  {
+    if( _memoShardCapacity.load( std::memory_order_relaxed ) == 0 )
+    {
+      return call( object, params, result );
+    }
+
+    // params are compared as they would be converted: trimmed and without their inverted commas,
+    // but flagged if quoted or escaped, as 'a\'b' reaches a string param as a'b and a\'b as written
+    std::string& key = _MemoKey( object, ( const void* ) call );
+
+    for( unsigned long i = 0; i < params.Size(); ++i )
+    {
+      _AppendKeyPart( key, params[i] );
+      key += ( char ) ( ( params.IsQuoted( i ) ? 1 : 0 ) | ( params.IsEscaped( i ) ? 2 : 0 ) );
+    }
+
+    if( _MemoFind( key, [&result]( const Value& value ) { value.AppendTo( result ); } ) )
+    {
+      return true;
+    }
+
+    // the key buffer may be reused if the method itself executes a Pure call
+    std::string callKey = key;
+    std::string text;
+
+    if( !call( object, params, text ) )
+    {
+      result += text;
+      return false;
+    }
+
+    _MemoStore( callKey, object, Value( text ) );
+    result += text;
+    return true;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void _InvokeMemoized( _interppInvoke invoke, void* object, const Value* args, unsigned long argCount, Value& result )
+  {
+    if( _memoShardCapacity.load( std::memory_order_relaxed ) == 0 )
+    {
+      invoke( object, args, argCount, result );
+      return;
+    }
+
+    // numbers are keyed by their exact bits, so that nearby reals do not share a result
+    std::string& key = _MemoKey( object, ( const void* ) invoke );
+
+    for( unsigned long i = 0; i < argCount; ++i )
+    {
+      key += ( char ) args[i].GetType();
+
+      switch( args[i].GetType() )
+      {
+        case Value::Bool:
+          key += ( char ) args[i].AsBool();
+          break;
+        case Value::Int:
+        {
+          long long integer = args[i].AsInt();
+          key.append( ( const char* ) &integer, sizeof( integer ) );
+          break;
+        }
+        case Value::Real:
+        {
+          double real = args[i].AsReal();
+          key.append( ( const char* ) &real, sizeof( real ) );
+          break;
+        }
+        default:
+          _AppendKeyPart( key, args[i].AsString() );
+          break;
+      }
+    }
+
+    // assigning reuses the capacity of the text result already holds
+    if( _MemoFind( key, [&result]( const Value& value ) { result = value; } ) )
+    {
+      return;
+    }
+
+    std::string callKey = key;
+    invoke( object, args, argCount, result );
+
+    if( !result.IsError() )
+    {
+      _MemoStore( callKey, object, result );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  MemoStats GetMemoStats()
+  {
+    MemoStats stats = { 0, 0, 0, 0 };
+
+    for( unsigned long i = 0; i < _memoShardCount; ++i )
+    {
+      _MemoShard& shard = _memoShards[i];
+      std::lock_guard< std::mutex > lock( shard.mutex );
+
+      stats.hits += shard.hits;
+      stats.misses += shard.misses;
+      stats.evictions += shard.evictions;
+      stats.entries += shard.entries.size();
+    }
+
+    return stats;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void SetMemoCapacity( unsigned long entryCount )
+  {
+    unsigned long shardCapacity = ( entryCount + _memoShardCount - 1 ) / _memoShardCount;
+    _memoShardCapacity.store( shardCapacity, std::memory_order_relaxed );
+
+    // trim shards that are now over capacity, oldest entries first
+    for( unsigned long i = 0; i < _memoShardCount; ++i )
+    {
+      _MemoShard& shard = _memoShards[i];
+      std::lock_guard< std::mutex > lock( shard.mutex );
+
+      while( shard.entries.size() > shardCapacity )
+      {
+        shard.index.erase( shard.entries.back().key );
+        shard.entries.pop_back();
+        ++shard.evictions;
+      }
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void InvalidateMemo( const void* object )
+  {
+    _MemoRemove( [object]( const _MemoEntry& entry ) { return entry.object == object; } );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void ClearMemo()
+  {
+    _MemoRemove( []( const _MemoEntry& ) { return true; } );
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    // the default AsyncExecutor: a fixed pool of threads taking tasks from one queue
+    class _ThreadPoolExecutor : public AsyncExecutor
+    {
+    public:
+      explicit _ThreadPoolExecutor( unsigned int threadCount )
+        : _stopping( false )
+      {
+        for( unsigned int i = 0; i < threadCount; ++i )
+        {
+          _threads.push_back( std::thread( &_ThreadPoolExecutor::_WorkerMain, this ) );
+        }
+      }
+
+      ~_ThreadPoolExecutor()
+      {
+        {
+          std::lock_guard< std::mutex > lock( _mutex );
+          _stopping = true;
+        }
+
+        _wake.notify_all();
+
+        for( unsigned long i = 0; i < _threads.size(); ++i )
+        {
+          _threads[i].join();
+        }
+      }
+
+      void Post( std::function< void() > task )
+      {
+        {
+          std::lock_guard< std::mutex > lock( _mutex );
+          _tasks.push_back( std::move( task ) );
+        }
+
+        _wake.notify_one();
+      }
+
+    private:
+      // queued tasks still run when the pool is stopping
+      void _WorkerMain()
+      {
+        while( true )
+        {
+          std::function< void() > task;
+
+          {
+            std::unique_lock< std::mutex > lock( _mutex );
+            _wake.wait( lock, [this]() { return _stopping || !_tasks.empty(); } );
+
+            if( _tasks.empty() )
+            {
+              return;
+            }
+
+            task = std::move( _tasks.front() );
+            _tasks.pop_front();
+          }
+
+          task();
+        }
+      }
+
+      std::vector< std::thread > _threads;
+      std::mutex _mutex;
+      std::condition_variable _wake;
+      std::deque< std::function< void() > > _tasks;
+      bool _stopping;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+
+    std::atomic< AsyncExecutor* > _asyncExecutor( NULL );
+
+    AsyncExecutor& _AsyncExecutor()
+    {
+      AsyncExecutor* executor = _asyncExecutor.load( std::memory_order_acquire );
+
+      if( executor == NULL )
+      {
+        // long-running methods typically block rather than compute, so allow some threads beyond
+        // the hardware's
+        static _ThreadPoolExecutor defaultExecutor( std::max( std::thread::hardware_concurrency(), 4u ) );
+        return defaultExecutor;
+      }
+
+      return *executor;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void SetAsyncExecutor( AsyncExecutor* executor )
+  {
+    _asyncExecutor.store( executor, std::memory_order_release );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool _ExecuteOrPost( _Registry& registry, std::string_view command, std::string& result, std::exception_ptr& error,
+                       std::function< void( std::exception_ptr ) > done )
+  {
+    _ArenaScope arena;
+    std::string_view objectName;
+    std::string_view methodName;
+    std::string_view params;
+
+    _SplitCommand( command, objectName, methodName, params );
+
+    void* object = NULL;
+    _InterppMethodInfo method = _InterppRegistry::GetMethod( objectName, methodName, &object, registry );
+
+    if( method.call == NULL || !( method.flags & LongRunning ) )
+    {
+      try
+      {
+        _CallResolved( object, method, params, result );
+      }
+      catch( ... )
+      {
+        error = std::current_exception();
+      }
+
+      return true;
+    }
+
+    _AsyncExecutor().Post( [object, method, params = std::string( params ), &result, done = std::move( done )]()
+    {
+      _ArenaScope arena;
+      std::exception_ptr error;
+
+      try
+      {
+        _CallResolved( object, method, params, result );
+      }
+      catch( ... )
+      {
+        error = std::current_exception();
+      }
+
+      done( error );
+    } );
+
+    return false;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    // ExecuteAsync() on the objects of registry
+    std::future< std::string > _ExecuteAsync( _Registry& registry, std::string_view command )
+    {
+      struct _AsyncCall
+      {
+        std::promise< std::string > promise;
+        std::string result;
+      };
+
+      std::shared_ptr< _AsyncCall > call = std::make_shared< _AsyncCall >();
+      std::future< std::string > future = call->promise.get_future();
+
+      std::exception_ptr thrown;
+
+      bool done = _ExecuteOrPost( registry, command, call->result, thrown, [call]( std::exception_ptr error )
+      {
+        if( error )
+        {
+          call->promise.set_exception( error );
+        }
+        else
+        {
+          call->promise.set_value( std::move( call->result ) );
+        }
+      } );
+
+      if( done && thrown )
+      {
+        call->promise.set_exception( thrown );
+      }
+      else if( done )
+      {
+        call->promise.set_value( std::move( call->result ) );
+      }
+
+      return future;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  std::future< std::string > ExecuteAsync( std::string_view command )
+  {
+    return _ExecuteAsync( _DefaultRegistry(), command );
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    enum _TokenType
+    {
+      _TokenEnd,
+      _TokenNewline,
+      _TokenInt,
+      _TokenReal,
+      _TokenString,
+      _TokenName,
+      _TokenSymbol
+    };
+
+    struct _Token
+    {
+      _TokenType type;
+      std::string_view text;
+      unsigned int line;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool _IsNameChar( char c )
+    {
+      return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) || c == '_';
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // Splits source into tokens. Newlines separate statements, except inside parentheses. Returns false
+    // with error set on an unterminated string or an unexpected character.
+    bool _Tokenize( std::string_view source, std::vector< _Token >& tokens, std::string& error )
+    {
+      static const char* const symbols[] = { "==", "!=", "<=", ">=", "&&", "||", "=", "<", ">", "+", "-", "*",
+                                             "/", "%", "!", "(", ")", "{", "}", ",", ".", ";" };
+
+      unsigned int line = 1;
+      unsigned long depth = 0;
+      std::size_t i = 0;
+
+      while( i < source.size() )
+      {
+        char c = source[i];
+        std::size_t start = i;
+        _TokenType type = _TokenSymbol;
+
+        if( c == '\n' )
+        {
+          if( depth == 0 && !tokens.empty() && tokens.back().type != _TokenNewline )
+          {
+            tokens.push_back( { _TokenNewline, source.substr( i, 1 ), line } );
+          }
+
+          ++line;
+          ++i;
+          continue;
+        }
+        else if( c == ' ' || c == '\t' || c == '\r' )
+        {
+          ++i;
+          continue;
+        }
+        else if( c == '/' && source.substr( i, 2 ) == "//" )
+        {
+          i = std::min( source.find( '\n', i ), source.size() );
+          continue;
+        }
+        else if( c >= '0' && c <= '9' )
+        {
+          type = _TokenInt;
+
+          while( i < source.size() && ( _IsNameChar( source[i] ) || source[i] == '.' ||
+                                        ( ( source[i] == '+' || source[i] == '-' ) && ( source[i - 1] == 'e' || source[i - 1] == 'E' ) ) ) )
+          {
+            type = source[i] == '.' || source[i] == 'e' || source[i] == 'E' ? _TokenReal : type;
+            ++i;
+          }
+        }
+        else if( _IsNameChar( c ) )
+        {
+          type = _TokenName;
+
+          while( i < source.size() && _IsNameChar( source[i] ) )
+          {
+            ++i;
+          }
+        }
+        else if( c == '\'' )
+        {
+          // quoted as in Execute(), with \' for an inverted comma
+          type = _TokenString;
+
+          for( ++i; i < source.size() && source[i] != '\''; ++i )
+          {
+            i += source[i] == '\\' && i + 1 < source.size() && source[i + 1] == '\'';
+          }
+
+          if( i++ >= source.size() )
+          {
+            error = "Error: line " + std::to_string( line ) + ": unterminated string";
+            return false;
+          }
+        }
+        else
+        {
+          unsigned long symbol = 0;
+
+          while( symbol < sizeof( symbols ) / sizeof( symbols[0] ) && source.substr( i, strlen( symbols[symbol] ) ) != symbols[symbol] )
+          {
+            ++symbol;
+          }
+
+          if( symbol == sizeof( symbols ) / sizeof( symbols[0] ) )
+          {
+            error = "Error: line " + std::to_string( line ) + ": unexpected '" + std::string( 1, c ) + "'";
+            return false;
+          }
+
+          i += strlen( symbols[symbol] );
+          depth += c == '(';
+          depth -= c == ')' && depth > 0;
+        }
+
+        tokens.push_back( { type, source.substr( start, i - start ), line } );
+      }
+
+      tokens.push_back( { _TokenEnd, std::string_view(), line } );
+      return true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool _IsTrue( const Value& value )
+    {
+      switch( value.GetType() )
+      {
+        case Value::Bool:
+          return value.AsBool();
+        case Value::Int:
+          return value.AsInt() != 0;
+        case Value::Real:
+          return value.AsReal() != 0;
+        case Value::String:
+          return !value.AsString().empty();
+        default:
+          return false;
+      }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool _IsNumber( const Value& value )
+    {
+      return value.GetType() == Value::Bool || value.GetType() == Value::Int || value.GetType() == Value::Real;
+    }
+
+    long long _ToInt( const Value& value )
+    {
+      return value.GetType() == Value::Bool ? value.AsBool() : value.AsInt();
+    }
+
+    double _ToReal( const Value& value )
+    {
+      return value.GetType() == Value::Real ? value.AsReal() : ( double ) _ToInt( value );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // Applies a binary operator, returning false with an error message in result if the operands
+    // do not support it. Integers wrap on overflow rather than invoking undefined behaviour.
+    bool _BinaryOp( unsigned short op, const Value& left, const Value& right, Value& result )
+    {
+      if( op == _OpAdd && ( left.GetType() == Value::String || right.GetType() == Value::String ) &&
+          !left.IsVoid() && !right.IsVoid() )
+      {
+        result = Value( left.ToString() + right.ToString() );
+        return true;
+      }
+
+      if( op >= _OpEqual && !( _IsNumber( left ) && _IsNumber( right ) ) )
+      {
+        if( left.GetType() == Value::String && right.GetType() == Value::String )
+        {
+          int order = left.AsString().compare( right.AsString() );
+          bool results[] = { order == 0, order != 0, order < 0, order <= 0, order > 0, order >= 0 };
+          result = Value( results[op - _OpEqual] );
+          return true;
+        }
+        else if( op == _OpEqual || op == _OpNotEqual )
+        {
+          // values of different kinds are never equal
+          result = Value( ( left.GetType() == right.GetType() ) == ( op == _OpEqual ) );
+          return true;
+        }
+      }
+
+      if( !_IsNumber( left ) || !_IsNumber( right ) )
+      {
+        result = Value( std::string( "operands must be numbers" ) );
+        return false;
+      }
+
+      if( left.GetType() == Value::Real || right.GetType() == Value::Real )
+      {
+        double l = _ToReal( left );
+        double r = _ToReal( right );
+
+        switch( op )
+        {
+          case _OpAdd:          result = Value( l + r ); return true;
+          case _OpSubtract:     result = Value( l - r ); return true;
+          case _OpMultiply:     result = Value( l * r ); return true;
+          case _OpDivide:       result = Value( l / r ); return true;
+          case _OpModulo:       result = Value( std::fmod( l, r ) ); return true;
+          case _OpEqual:        result = Value( l == r ); return true;
+          case _OpNotEqual:     result = Value( l != r ); return true;
+          case _OpLess:         result = Value( l < r ); return true;
+          case _OpLessEqual:    result = Value( l <= r ); return true;
+          case _OpGreater:      result = Value( l > r ); return true;
+          default:              result = Value( l >= r ); return true;
+        }
+      }
+
+      long long l = _ToInt( left );
+      long long r = _ToInt( right );
+
+      if( ( op == _OpDivide || op == _OpModulo ) && r == 0 )
+      {
+        result = Value( std::string( "division by zero" ) );
+        return false;
+      }
+
+      switch( op )
+      {
+        case _OpAdd:          result = Value( ( long long ) ( ( unsigned long long ) l + ( unsigned long long ) r ) ); return true;
+        case _OpSubtract:     result = Value( ( long long ) ( ( unsigned long long ) l - ( unsigned long long ) r ) ); return true;
+        case _OpMultiply:     result = Value( ( long long ) ( ( unsigned long long ) l * ( unsigned long long ) r ) ); return true;
+        case _OpDivide:       result = Value( r == -1 ? ( long long ) ( 0 - ( unsigned long long ) l ) : l / r ); return true;
+        case _OpModulo:       result = Value( r == -1 ? 0LL : l % r ); return true;
+        case _OpEqual:        result = Value( l == r ); return true;
+        case _OpNotEqual:     result = Value( l != r ); return true;
+        case _OpLess:         result = Value( l < r ); return true;
+        case _OpLessEqual:    result = Value( l <= r ); return true;
+        case _OpGreater:      result = Value( l > r ); return true;
+        default:              result = Value( l >= r ); return true;
+      }
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  // Compiles tokens into a Script in one recursive-descent pass. Every name that is not followed by
+  // '.' is a variable; variables take the lowest registers, and temporaries are allocated above them
+  // for the duration of a statement.
+  class _ScriptCompiler
+  {
+  public:
+    _ScriptCompiler( const std::vector< _Token >& tokens, Script& script, Interpreter& interpreter )
+      : _tokens( tokens ),
+        _next( 0 ),
+        _script( script ),
+        _interpreter( interpreter ),
+        _nextTemp( 0 ),
+        _label( 0 )
+    {
+      for( unsigned long i = 0; i + 1 < tokens.size(); ++i )
+      {
+        bool isMember = tokens[i + 1].text == "." || ( i > 0 && tokens[i - 1].text == "." );
+
+        if( tokens[i].type == _TokenName && !_IsKeyword( tokens[i].text ) && !isMember &&
+            _Variable( tokens[i].text ) == script._variables.size() )
+        {
+          script._variables.push_back( std::string( tokens[i].text ) );
+        }
+      }
+
+      _nextTemp = script._variables.size();
+    }
+
+    bool Compile()
+    {
+      while( _Peek().type != _TokenEnd )
+      {
+        if( !_Statement() )
+        {
+          return false;
+        }
+      }
+
+      return _Check( _script._variables.size() <= 0xFFFF && _script._constants.size() <= 0xFFFF &&
+                     _script._calls.size() <= 0xFFFF && _script._code.size() <= 0xFFFF, "script is too large" );
+    }
+
+  private:
+    static bool _IsKeyword( std::string_view name )
+    {
+      return name == "if" || name == "else" || name == "while" || name == "true" || name == "false";
+    }
+
+    unsigned long _Variable( std::string_view name ) const
+    {
+      unsigned long i = 0;
+
+      while( i < _script._variables.size() && _script._variables[i] != name )
+      {
+        ++i;
+      }
+
+      return i;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    const _Token& _Peek() const
+    {
+      return _tokens[_next];
+    }
+
+    bool _Accept( std::string_view symbol )
+    {
+      if( _Peek().type == _TokenSymbol && _Peek().text == symbol )
+      {
+        ++_next;
+        return true;
+      }
+
+      return false;
+    }
+
+    bool _Expect( std::string_view symbol )
+    {
+      return _Check( _Accept( symbol ), "expected '" + std::string( symbol ) + "'" );
+    }
+
+    void _SkipNewlines()
+    {
+      while( _Peek().type == _TokenNewline )
+      {
+        ++_next;
+      }
+    }
+
+    bool _Check( bool condition, const std::string& message )
+    {
+      if( !condition && _script._error.empty() )
+      {
+        _script._error = "Error: line " + std::to_string( _Peek().line ) + ": " + message;
+      }
+
+      return condition;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    unsigned long _Emit( unsigned short op, unsigned long a, unsigned long b = 0, unsigned long c = 0 )
+    {
+      _ScriptInstruction instruction = { op, ( unsigned short ) a, ( unsigned short ) b, ( unsigned short ) c };
+      _script._code.push_back( instruction );
+      _script._lines.push_back( _tokens[_next > 0 ? _next - 1 : 0].line );
+      return _script._code.size() - 1;
+    }
+
+    // points the jump at instruction jump to the next instruction emitted
+    void _Patch( unsigned long jump )
+    {
+      _label = _script._code.size();
+      _script._code[jump].b = ( unsigned short ) _label;
+    }
+
+    unsigned short _Temp()
+    {
+      _script._registerCount = std::max< unsigned long >( _script._registerCount, _nextTemp + 1 );
+      return ( unsigned short ) _nextTemp++;
+    }
+
+    // Puts the value of the next expression in register target. If the expression's last instruction
+    // wrote a temporary, it is redirected to target rather than followed by a move.
+    bool _ExpressionInto( unsigned short target )
+    {
+      unsigned short value;
+
+      if( !_Expression( value ) )
+      {
+        return false;
+      }
+
+      if( value != target )
+      {
+        _ScriptInstruction* last = _script._code.empty() ? NULL : &_script._code.back();
+
+        if( value >= _script._variables.size() && last != NULL && last->a == value && _label != _script._code.size() &&
+            last->op != _OpJump && last->op != _OpJumpIfFalse && last->op != _OpJumpIfTrue && last->op != _OpResult )
+        {
+          last->a = target;
+        }
+        else
+        {
+          _Emit( _OpMove, target, value );
+        }
+      }
+
+      return true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool _Statement()
+    {
+      _SkipNewlines();
+
+      if( _Peek().type == _TokenEnd || ( _Peek().type == _TokenSymbol && _Peek().text == "}" ) )
+      {
+        return true;
+      }
+
+      unsigned long temps = _nextTemp;
+      bool compiled = false;
+
+      if( _Peek().type == _TokenName && _Peek().text == "if" )
+      {
+        ++_next;
+        compiled = _If();
+      }
+      else if( _Peek().type == _TokenName && _Peek().text == "while" )
+      {
+        ++_next;
+        compiled = _While();
+      }
+      else if( _Peek().type == _TokenName && !_IsKeyword( _Peek().text ) &&
+               _tokens[_next + 1].type == _TokenSymbol && _tokens[_next + 1].text == "=" )
+      {
+        unsigned long variable = _Variable( _Peek().text );
+        _next += 2;
+        compiled = _ExpressionInto( ( unsigned short ) variable );
+      }
+      else
+      {
+        unsigned short value;
+        compiled = _Expression( value );
+
+        if( compiled )
+        {
+          _Emit( _OpResult, value );
+        }
+      }
+
+      _nextTemp = temps;
+
+      if( !compiled )
+      {
+        return false;
+      }
+
+      return _Accept( ";" ) || _Peek().type == _TokenNewline || _Peek().type == _TokenEnd ||
+             ( _Peek().type == _TokenSymbol && _Peek().text == "}" ) || _Check( false, "expected end of statement" );
+    }
+
+    bool _Block()
+    {
+      _SkipNewlines();
+
+      if( !_Expect( "{" ) )
+      {
+        return false;
+      }
+
+      while( !_Accept( "}" ) )
+      {
+        if( !_Check( _Peek().type != _TokenEnd, "expected '}'" ) || !_Statement() )
+        {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    bool _If()
+    {
+      unsigned short condition;
+
+      if( !_Expression( condition ) )
+      {
+        return false;
+      }
+
+      unsigned long skipThen = _Emit( _OpJumpIfFalse, condition );
+
+      if( !_Block() )
+      {
+        return false;
+      }
+
+      unsigned long next = _next;
+      _SkipNewlines();
+
+      if( !( _Peek().type == _TokenName && _Peek().text == "else" ) )
+      {
+        // leave the newline to end the statement
+        _next = next;
+        _Patch( skipThen );
+        return true;
+      }
+
+      ++_next;
+      unsigned long skipElse = _Emit( _OpJump, 0 );
+      _Patch( skipThen );
+
+      if( _Peek().type == _TokenName && _Peek().text == "if" )
+      {
+        ++_next;
+
+        if( !_If() )
+        {
+          return false;
+        }
+      }
+      else if( !_Block() )
+      {
+        return false;
+      }
+
+      _Patch( skipElse );
+      return true;
+    }
+
+    bool _While()
+    {
+      unsigned long top = _script._code.size();
+      unsigned short condition;
+
+      if( !_Expression( condition ) )
+      {
+        return false;
+      }
+
+      unsigned long exit = _Emit( _OpJumpIfFalse, condition );
+
+      if( !_Block() )
+      {
+        return false;
+      }
+
+      _Emit( _OpJump, 0, top );
+      _Patch( exit );
+      return true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // each _Expression level returns the register holding its value in value
+
+    bool _Expression( unsigned short& value )
+    {
+      return _Logical( value, 0 );
+    }
+
+    // level 0 is ||, level 1 is &&; each short-circuits and yields a Bool
+    bool _Logical( unsigned short& value, int level )
+    {
+      if( !( level == 0 ? _Logical( value, 1 ) : _Comparison( value ) ) )
+      {
+        return false;
+      }
+
+      const char* symbol = level == 0 ? "||" : "&&";
+
+      if( !( _Peek().type == _TokenSymbol && _Peek().text == symbol ) )
+      {
+        return true;
+      }
+
+      unsigned short result = _Temp();
+      std::vector< unsigned long > jumps;
+
+      _Emit( _OpMove, result, value );
+
+      while( _Accept( symbol ) )
+      {
+        jumps.push_back( _Emit( level == 0 ? _OpJumpIfTrue : _OpJumpIfFalse, result ) );
+
+        unsigned long temps = _nextTemp;
+        bool compiled = level == 0 ? _Logical( value, 1 ) : _Comparison( value );
+        _nextTemp = temps;
+
+        if( !compiled )
+        {
+          return false;
+        }
+
+        _Emit( _OpMove, result, value );
+      }
+
+      for( unsigned long i = 0; i < jumps.size(); ++i )
+      {
+        _Patch( jumps[i] );
+      }
+
+      _Emit( _OpToBool, result, result );
+      value = result;
+      return true;
+    }
+
+    bool _Comparison( unsigned short& value )
+    {
+      static const char* const symbols[] = { "==", "!=", "<", "<=", ">", ">=" };
+      return _Binary( value, symbols, 6, _OpEqual, &_ScriptCompiler::_Sum, false );
+    }
+
+    bool _Sum( unsigned short& value )
+    {
+      static const char* const symbols[] = { "+", "-" };
+      return _Binary( value, symbols, 2, _OpAdd, &_ScriptCompiler::_Product, true );
+    }
+
+    bool _Product( unsigned short& value )
+    {
+      static const char* const symbols[] = { "*", "/", "%" };
+      return _Binary( value, symbols, 3, _OpMultiply, &_ScriptCompiler::_Unary, true );
+    }
+
+    // parses operands of the next level joined by symbols, which map to consecutive ops from firstOp
+    bool _Binary( unsigned short& value, const char* const* symbols, unsigned long symbolCount, unsigned short firstOp,
+                  bool ( _ScriptCompiler::*operand )( unsigned short& ), bool repeat )
+    {
+      if( !( this->*operand )( value ) )
+      {
+        return false;
+      }
+
+      do
+      {
+        unsigned long symbol = 0;
+
+        while( symbol < symbolCount && !( _Peek().type == _TokenSymbol && _Peek().text == symbols[symbol] ) )
+        {
+          ++symbol;
+        }
+
+        if( symbol == symbolCount )
+        {
+          return true;
+        }
+
+        ++_next;
+
+        unsigned short right;
+
+        if( !( this->*operand )( right ) )
+        {
+          return false;
+        }
+
+        unsigned short result = _Temp();
+        _Emit( firstOp + symbol, result, value, right );
+        value = result;
+      }
+      while( repeat );
+
+      return true;
+    }
+
+    bool _Unary( unsigned short& value )
+    {
+      if( _Accept( "-" ) || _Accept( "!" ) )
+      {
+        unsigned short op = _tokens[_next - 1].text == "-" ? _OpNegate : _OpNot;
+        unsigned short operand;
+
+        if( !_Unary( operand ) )
+        {
+          return false;
+        }
+
+        value = _Temp();
+        _Emit( op, value, operand );
+        return true;
+      }
+
+      return _Primary( value );
+    }
+
+    bool _Primary( unsigned short& value )
+    {
+      const _Token& token = _Peek();
+
+      if( _Accept( "(" ) )
+      {
+        return _Expression( value ) && _Expect( ")" );
+      }
+      else if( token.type == _TokenInt || token.type == _TokenReal )
+      {
+        long long integer = 0;
+        double real = 0;
+
+        if( token.type == _TokenInt && ValueConverter< long long >::FromString( token.text, integer ) )
+        {
+          return _Constant( Value( integer ), value );
+        }
+        else if( ValueConverter< double >::FromString( token.text, real ) )
+        {
+          return _Constant( Value( real ), value );
+        }
+
+        return _Check( false, "invalid number '" + std::string( token.text ) + "'" );
+      }
+      else if( token.type == _TokenString )
+      {
+        std::string text;
+
+        for( std::size_t i = 1; i + 1 < token.text.size(); ++i )
+        {
+          i += token.text[i] == '\\' && token.text[i + 1] == '\'';
+          text += token.text[i];
+        }
+
+        return _Constant( Value( text ), value );
+      }
+      else if( token.type == _TokenName && ( token.text == "true" || token.text == "false" ) )
+      {
+        return _Constant( Value( token.text == "true" ), value );
+      }
+      else if( token.type == _TokenName && !_IsKeyword( token.text ) )
+      {
+        ++_next;
+
+        if( _Accept( "." ) )
+        {
+          return _Call( token.text, value );
+        }
+
+        value = ( unsigned short ) _Variable( token.text );
+        return true;
+      }
+
+      return _Check( false, token.type == _TokenEnd || token.type == _TokenNewline ? std::string( "expected an expression" ) :
+                                                                                    "unexpected '" + std::string( token.text ) + "'" );
+    }
+
+    bool _Constant( const Value& constant, unsigned short& value )
+    {
+      ++_next;
+      _script._constants.push_back( constant );
+      value = _Temp();
+      _Emit( _OpLoadConst, value, _script._constants.size() - 1 );
+      return true;
+    }
+
+    // object.Method( args ): args are evaluated into consecutive temporaries
+    bool _Call( std::string_view objectName, unsigned short& value )
+    {
+      if( !_Check( _Peek().type == _TokenName, "expected a method name" ) )
+      {
+        return false;
+      }
+
+      _ScriptCall call = { CallSite( objectName, _Peek().text, _interpreter ), 0 };
+      ++_next;
+
+      if( !_Expect( "(" ) )
+      {
+        return false;
+      }
+
+      unsigned long firstArg = _nextTemp;
+
+      if( !_Accept( ")" ) )
+      {
+        do
+        {
+          // each arg's own temporaries are released once it is in place, so the next arg's register
+          // directly follows it
+          unsigned short arg = _Temp();
+
+          if( !_ExpressionInto( arg ) )
+          {
+            return false;
+          }
+
+          _nextTemp = arg + 1;
+          ++call.argCount;
+        }
+        while( _Accept( "," ) );
+
+        if( !_Expect( ")" ) )
+        {
+          return false;
+        }
+      }
+
+      _script._calls.push_back( call );
+
+      value = _Temp();
+      _Emit( _OpCall, value, _script._calls.size() - 1, firstArg );
+      return true;
+    }
+
+    const std::vector< _Token >& _tokens;
+    unsigned long _next;
+    Script& _script;
+    Interpreter& _interpreter;
+    unsigned long _nextTemp;
+    unsigned long _label;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  Script CompileScript( std::string_view source, Interpreter& interpreter )
+  {
+    Script script;
+    std::vector< _Token > tokens;
+
+    if( _Tokenize( source, tokens, script._error ) )
+    {
+      _ScriptCompiler( tokens, script, interpreter ).Compile();
+    }
+
+    if( !script.IsValid() )
+    {
+      return script;
+    }
+
+    script._registerCount = std::max< unsigned long >( script._registerCount, script._variables.size() );
+    script._registers.resize( script._registerCount );
+    return script;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    Value _ScriptError( unsigned int line, std::string_view message )
+    {
+      if( message.substr( 0, 7 ) == "Error: " )
+      {
+        message.remove_prefix( 7 );
+      }
+
+      return Value::MakeError( "Error: line " + std::to_string( line ) + ": " + std::string( message ) );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  Value Script::Run()
+  {
+    if( !IsValid() )
+    {
+      return Value::MakeError( _error );
+    }
+
+    Value result;
+    Value* registers = _registers.data();
+    unsigned long pc = 0;
+
+    while( pc < _code.size() )
+    {
+      const _ScriptInstruction& instruction = _code[pc++];
+      Value& target = registers[instruction.a];
+
+      switch( instruction.op )
+      {
+        case _OpLoadConst:
+          target = _constants[instruction.b];
+          break;
+
+        case _OpMove:
+          target = registers[instruction.b];
+          break;
+
+        case _OpNegate:
+        {
+          const Value& operand = registers[instruction.b];
+
+          if( operand.GetType() == Value::Real )
+          {
+            target = Value( -operand.AsReal() );
+          }
+          else if( _IsNumber( operand ) )
+          {
+            target = Value( ( long long ) ( 0 - ( unsigned long long ) _ToInt( operand ) ) );
+          }
+          else
+          {
+            return _ScriptError( _lines[pc - 1], "operand must be a number" );
+          }
+
+          break;
+        }
+
+        case _OpNot:
+          target = Value( !_IsTrue( registers[instruction.b] ) );
+          break;
+
+        case _OpToBool:
+          target = Value( _IsTrue( registers[instruction.b] ) );
+          break;
+
+        case _OpJump:
+          pc = instruction.b;
+          break;
+
+        case _OpJumpIfFalse:
+          pc = _IsTrue( target ) ? pc : instruction.b;
+          break;
+
+        case _OpJumpIfTrue:
+          pc = _IsTrue( target ) ? instruction.b : pc;
+          break;
+
+        case _OpCall:
+        {
+          _ScriptCall& call = _calls[instruction.b];
+          target = call.site.Invoke( registers + instruction.c, call.argCount );
+
+          if( target.IsError() )
+          {
+            return _ScriptError( _lines[pc - 1], target.AsString() );
+          }
+
+          break;
+        }
+
+        case _OpResult:
+          result = target;
+          break;
+
+        default:
+          // operands are read before target is written, so target may be one of them
+          if( !_BinaryOp( instruction.op, registers[instruction.b], registers[instruction.c], target ) )
+          {
+            return _ScriptError( _lines[pc - 1], target.AsString() );
+          }
+
+          break;
+      }
+    }
+
+    return result;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool Script::SetVariable( std::string_view name, const Value& value )
+  {
+    for( unsigned long i = 0; i < _variables.size(); ++i )
+    {
+      if( _variables[i] == name )
+      {
+        _registers[i] = value;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool Script::GetVariable( std::string_view name, Value& value ) const
+  {
+    for( unsigned long i = 0; i < _variables.size(); ++i )
+    {
+      if( _variables[i] == name )
+      {
+        value = _registers[i];
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  InlineCacheStats Script::CallStats() const
+  {
+    InlineCacheStats stats = { 0, 0 };
+
+    for( unsigned long i = 0; i < _calls.size(); ++i )
+    {
+      stats.hits += _calls[i].site.Stats().hits;
+      stats.misses += _calls[i].site.Stats().misses;
+    }
+
+    return stats;
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    // A scanner stores the offsets of the delimiters in text from position on, stopping at the end
+    // of the block in which its offsets could overflow
+    void _ScanStructureScalar( std::string_view text, std::size_t& position, unsigned int* offsets, unsigned long capacity, unsigned long& count )
+    {
+      for( ; position < text.size() && count < capacity; ++position )
+      {
+        switch( text[position] )
+        {
+          case '.':
+          case '(':
+          case ')':
+          case ',':
+          case '[':
+          case ']':
+          case '\'':
+          case '\"':
+            offsets[count++] = ( unsigned int ) position;
+            break;
+          default:
+            break;
+        }
+      }
+    }
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+
+    unsigned int _TrailingZeros( unsigned int bits )
+    {
+#if defined( __GNUC__ )
+      return __builtin_ctz( bits );
+#elif defined( _MSC_VER )
+      unsigned long index;
+      _BitScanForward( &index, bits );
+      return index;
+#else
+      unsigned int count = 0;
+
+      for( ; ( bits & 1 ) == 0; bits >>= 1 )
+      {
+        count++;
+      }
+
+      return count;
+#endif
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // SSE2 is part of x86-64, so this needs no check. Without a byte shuffle, each delimiter takes a
+    // compare.
+    void _ScanStructureSse2( std::string_view text, std::size_t& position, unsigned int* offsets, unsigned long capacity, unsigned long& count )
+    {
+      const char delimiters[] = { '.', '(', ')', ',', '[', ']', '\'', '\"' };
+      __m128i splats[sizeof( delimiters )];
+
+      for( unsigned long d = 0; d < sizeof( delimiters ); ++d )
+      {
+        splats[d] = _mm_set1_epi8( delimiters[d] );
+      }
+
+      // kept in locals, as stores through offsets could otherwise alias them
+      std::size_t i = position;
+      unsigned long found = count;
+
+      for( ; i + 16 <= text.size() && found + 16 <= capacity; i += 16 )
+      {
+        __m128i block = _mm_loadu_si128( ( const __m128i* ) ( text.data() + i ) );
+        __m128i matches = _mm_cmpeq_epi8( block, splats[0] );
+
+        for( unsigned long d = 1; d < sizeof( delimiters ); ++d )
+        {
+          matches = _mm_or_si128( matches, _mm_cmpeq_epi8( block, splats[d] ) );
+        }
+
+        for( unsigned int bits = _mm_movemask_epi8( matches ); bits != 0; bits &= bits - 1 )
+        {
+          offsets[found++] = ( unsigned int ) ( i + _TrailingZeros( bits ) );
+        }
+      }
+
+      position = i;
+      count = found;
+
+      if( count + 16 <= capacity )
+      {
+        _ScanStructureScalar( text, position, offsets, capacity, count );
+      }
+    }
+
+#endif
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void _FindStructure( std::string_view text, std::size_t& position, unsigned int* offsets, unsigned long capacity, unsigned long& count )
+  {
+    count = 0;
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+    _ScanStructureSse2( text, position, offsets, capacity, count );
+#else
+    _ScanStructureScalar( text, position, offsets, capacity, count );
+#endif
+  }
+
+  //=================================================================================================
+
+  bool _RegisterMethodNode( _MethodNode* node )
+  {
+    node->next = _pendingMethods.load( std::memory_order_relaxed );
+
+    while( !_pendingMethods.compare_exchange_weak( node->next, node, std::memory_order_release, std::memory_order_relaxed ) )
+    {
+    }
+
+    return true;
+  }
+
+  //=================================================================================================
+
+  RegistrationBatch::RegistrationBatch()
+    : _registry( &_DefaultRegistry() )
+  {
+    _Open();
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  RegistrationBatch::RegistrationBatch( Interpreter& interpreter )
+    : _registry( &interpreter._GetRegistry() )
+  {
+    _Open();
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void RegistrationBatch::_Open()
+  {
+    _RegistrationBatchState* batch = _OpenBatch( *_registry );
+
+    if( batch != NULL )
+    {
+      batch->depth++;
+      return;
+    }
+
+    _RegistrationBatchState opened = { _registry, 1, NULL, std::unique_lock< std::mutex >( _registry->writer.mutex ), std::vector< void* >() };
+    const _RegistrySnapshot* current = _registry->current.load();
+
+    opened.snapshot = current ? new _RegistrySnapshot( *current ) : new _RegistrySnapshot();
+    _registrationBatches.push_back( std::move( opened ) );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  RegistrationBatch::~RegistrationBatch()
+  {
+    _RegistrationBatchState* batch = _OpenBatch( *_registry );
+
+    if( --batch->depth != 0 )
+    {
+      return;
+    }
+
+    _Publish( *_registry, batch->snapshot );
+    batch->lock.unlock();
+
+    std::vector< void* > unregistered;
+    unregistered.swap( batch->unregistered );
+    _registrationBatches.erase( _registrationBatches.begin() + ( batch - _registrationBatches.data() ) );
+
+    for( unsigned long i = 0; i < unregistered.size(); ++i )
+    {
+      InvalidateMemo( unregistered[i] );
+    }
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    // looks the method up for the object found by key (a name or a handle) in registry
+    template< class Key >
+    _InterppMethodInfo _GetMethod( const _Registry& registry, Key key, std::string_view methodName, void** object,
+                                   void** registeredObject )
+    {
+      _AddPendingMethods();
+
+      _InterppMethodInfo notFound = { NULL, NULL, NULL, 0 };
+      _RegistryReader snapshot( registry );
+
+      if( snapshot.IsEmpty() )
+      {
+        return notFound;
+      }
+
+      const _ObjectSlot* slot = _FindSlot( *snapshot.Get(), key );
+
+      if( &registry == &_DefaultRegistry() )
+      {
+        return _FindMethod( *snapshot.Get(), slot, methodName, object, registeredObject );
+      }
+
+      // other registries hold objects only; their types' methods are in the default one
+      _RegistryReader types( _DefaultRegistry() );
+
+      if( types.IsEmpty() )
+      {
+        if( slot != NULL && object != NULL )
+        {
+          *object = slot->info.object;
+        }
+
+        if( slot != NULL && registeredObject != NULL )
+        {
+          *registeredObject = slot->info.object;
+        }
+
+        return notFound;
+      }
+
+      return _FindMethod( *types.Get(), slot, methodName, object, registeredObject );
+    }
+
+    // the id of typeName in the default registry, where methods and bases are looked up by type
+    unsigned int _DefaultTypeId( const std::string& typeName )
+    {
+      _AddPendingMethods();
+
+      {
+        _RegistryReader types( _DefaultRegistry() );
+        unsigned int typeId = types.IsEmpty() ? 0 : types->symbols.Find( typeName );
+
+        if( typeId != 0 )
+        {
+          return typeId;
+        }
+      }
+
+      unsigned int typeId = 0;
+
+      _PublishSnapshot( _DefaultRegistry(), [&]( _RegistrySnapshot& snapshot, std::deque< std::string >& symbolNames )
+      {
+        typeId = snapshot.symbols.Intern( typeName, symbolNames );
+      } );
+
+      return typeId;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void* _InterppRegistry::GetObject( std::string_view objectName, _Registry& registry )
+  {
+    _RegistryReader snapshot( registry );
+
+    if( snapshot.IsEmpty() )
+    {
+      return NULL;
+    }
+
+    const _ObjectSlot* slot = _FindSlot( *snapshot.Get(), objectName );
+    return slot != NULL ? slot->info.object : NULL;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void* _InterppRegistry::GetObject( ObjectHandle handle, _Registry& registry )
+  {
+    _RegistryReader snapshot( registry );
+
+    if( snapshot.IsEmpty() )
+    {
+      return NULL;
+    }
+
+    const _ObjectSlot* slot = _FindSlot( *snapshot.Get(), handle );
+    return slot != NULL ? slot->info.object : NULL;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  _InterppMethodInfo _InterppRegistry::GetMethod( std::string_view objectName, std::string_view methodName, void** object,
+                                                  _Registry& registry, void** registeredObject )
+  {
+    return _GetMethod( registry, objectName, methodName, object, registeredObject );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  _InterppMethodInfo _InterppRegistry::GetMethod( ObjectHandle handle, std::string_view methodName, void** object,
+                                                  _Registry& registry, void** registeredObject )
+  {
+    return _GetMethod( registry, handle, methodName, object, registeredObject );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void* _InterppRegistry::GetObject( std::string_view objectName, unsigned int& typeId, _Registry& registry )
+  {
+    _RegistryReader snapshot( registry );
+
+    if( snapshot.IsEmpty() )
+    {
+      return NULL;
+    }
+
+    const _ObjectSlot* slot = _FindSlot( *snapshot.Get(), objectName );
+
+    if( slot == NULL )
+    {
+      return NULL;
+    }
+
+    typeId = slot->info.typeId;
+    return slot->info.object;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  _InterppMethodInfo _InterppRegistry::FindMethod( unsigned int typeId, std::string_view methodName, void*& object )
+  {
+    _AddPendingMethods();
+
+    _InterppMethodInfo notFound = { NULL, NULL, NULL, 0 };
+    _RegistryReader snapshot( _DefaultRegistry() );
+
+    if( snapshot.IsEmpty() )
+    {
+      return notFound;
+    }
+
+    unsigned int methodId = snapshot->symbols.Find( methodName );
+    void* target = object;
+    const _InterppMethodInfo* methodInfo = methodId != 0 ? _FindTypeMethod( *snapshot.Get(), typeId, methodId, target ) : NULL;
+
+    if( methodInfo == NULL )
+    {
+      return notFound;
+    }
+
+    object = target;
+    return *methodInfo;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  ObjectHandle _InterppRegistry::_AddObject( _Registry& registry, const std::string& typeName, void* object, const std::string& objectName )
+  {
+    ObjectHandle handle = 0;
+    bool isDefault = &registry == &_DefaultRegistry();
+    unsigned int typeId = isDefault ? 0 : _DefaultTypeId( typeName );
+
+    _PublishSnapshot( registry, [&]( _RegistrySnapshot& snapshot, std::deque< std::string >& symbolNames )
+    {
+      unsigned int nameId = snapshot.symbols.Intern( objectName, symbolNames );
+      const unsigned int* index = snapshot.objects.Find( nameId );
+
+      if( isDefault )
+      {
+        typeId = snapshot.symbols.Intern( typeName, symbolNames );
+      }
+
+      // the object registered under this name is replaced, and its handle goes stale
+      if( index != NULL )
+      {
+        _FreeSlot( snapshot, *index );
+      }
+
+      handle = _AllocateSlot( snapshot, nameId, typeId, object );
+    } );
+
+    return handle;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    // removes the object found by key (a name or a handle); returns false if there was none
+    template< class Key >
+    bool _RemoveObject( _Registry& registry, Key key )
+    {
+      void* object = NULL;
+
+      _PublishSnapshot( registry, [&]( _RegistrySnapshot& snapshot, std::deque< std::string >& )
+      {
+        const _ObjectSlot* slot = _FindSlot( snapshot, key );
+
+        if( slot == NULL )
+        {
+          return;
+        }
+
+        object = slot->info.object;
+        snapshot.objects.Erase( slot->nameId );
+        _FreeSlot( snapshot, ( unsigned int ) ( slot - snapshot.objectSlots.data() ) );
+      } );
+
+      if( object == NULL )
+      {
+        return false;
+      }
+
+      // while a batch is open, the object stays visible to other threads, which may memoize more
+      _RegistrationBatchState* batch = _OpenBatch( registry );
+
+      if( batch != NULL )
+      {
+        batch->unregistered.push_back( object );
+      }
+      else
+      {
+        InvalidateMemo( object );
+      }
+
+      return true;
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool _InterppRegistry::RemoveObject( std::string_view objectName, _Registry& registry )
+  {
+    return _RemoveObject( registry, objectName );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool _InterppRegistry::RemoveObject( ObjectHandle handle, _Registry& registry )
+  {
+    return _RemoveObject( registry, handle );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void _InterppRegistry::_AddMethod( const std::string& typeName, const _InterppMethodInfo& methodInfo, const std::string& methodName )
+  {
+    _PublishSnapshot( _DefaultRegistry(), [&]( _RegistrySnapshot& snapshot, std::deque< std::string >& symbolNames )
+    {
+      unsigned int typeId = snapshot.symbols.Intern( typeName, symbolNames );
+      unsigned int methodId = snapshot.symbols.Intern( methodName, symbolNames );
+
+      snapshot.methods[ _MethodKey( typeId, methodId ) ] = methodInfo;
+    } );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void _InterppRegistry::_AddBase( const std::string& typeName, const std::string& baseTypeName, _interppUpcast upcast )
+  {
+    _PublishSnapshot( _DefaultRegistry(), [&]( _RegistrySnapshot& snapshot, std::deque< std::string >& symbolNames )
+    {
+      unsigned int typeId = snapshot.symbols.Intern( typeName, symbolNames );
+      _BaseLink base = { snapshot.symbols.Intern( baseTypeName, symbolNames ), upcast, 0 };
+      unsigned int index = ( unsigned int ) snapshot.baseLinks.size();
+      const unsigned int* firstLink = snapshot.bases.Find( typeId );
+
+      snapshot.baseLinks.push_back( base );
+
+      if( firstLink == NULL )
+      {
+        snapshot.bases[typeId] = index;
+        return;
+      }
+
+      // appended, so that bases are searched in the order they were registered
+      unsigned int last = *firstLink;
+
+      while( snapshot.baseLinks[last].next != 0 )
+      {
+        last = snapshot.baseLinks[last].next - 1;
+      }
+
+      snapshot.baseLinks[last].next = index + 1;
+    } );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned long long _RegistryEpoch( _Registry& registry )
+  {
+    _Registry& types = _DefaultRegistry();
+
+    // both counts only grow, so their sum changes whenever either does
+    return &registry == &types ? types.published.load() : registry.published.load() + types.published.load();
+  }
+
+  //=================================================================================================
+
+  bool UnregisterObject( std::string_view objectName )
+  {
+    return _InterppRegistry::RemoveObject( objectName );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool UnregisterObject( ObjectHandle handle )
+  {
+    return _InterppRegistry::RemoveObject( handle );
+  }
+
+  //=================================================================================================
+
+  Interpreter::Interpreter()
+    : _registry( new _Registry() ),
+      _ownsRegistry( true ) {}
+
+  //-------------------------------------------------------------------------------------------------
+
+  Interpreter::Interpreter( _Registry* registry )
+    : _registry( registry ),
+      _ownsRegistry( false ) {}
+
+  //-------------------------------------------------------------------------------------------------
+
+  Interpreter::~Interpreter()
+  {
+    if( !_ownsRegistry )
+    {
+      return;
+    }
+
+    const _RegistrySnapshot* current = _registry->current.load();
+
+    // memoized results are keyed by object, and the memory of these may be reused for others
+    if( current != NULL )
+    {
+      for( unsigned long i = 0; i < current->objectSlots.size(); ++i )
+      {
+        if( current->objectSlots[i].info.object != NULL )
+        {
+          InvalidateMemo( current->objectSlots[i].info.object );
+        }
+      }
+    }
+
+    delete current;
+
+    for( unsigned long i = 0; i < _registry->writer.retired.size(); ++i )
+    {
+      delete _registry->writer.retired[i].snapshot;
+    }
+
+    delete _registry;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  Interpreter& Interpreter::Default()
+  {
+    static Interpreter interpreter( &_DefaultRegistry() );
+    return interpreter;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool Interpreter::UnregisterObject( std::string_view objectName )
+  {
+    return _InterppRegistry::RemoveObject( objectName, *_registry );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool Interpreter::UnregisterObject( ObjectHandle handle )
+  {
+    return _InterppRegistry::RemoveObject( handle, *_registry );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  ExecuteStatus Interpreter::Execute( std::string_view command, char* buffer, std::size_t capacity, std::size_t& size )
+  {
+    return _ExecuteToBuffer( *_registry, command, buffer, capacity, size );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  std::future< std::string > Interpreter::ExecuteAsync( std::string_view command )
+  {
+    return _ExecuteAsync( *_registry, command );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void Interpreter::ExecuteBatch( const std::string_view* commands, unsigned long commandCount, BatchResults& results )
+  {
+    _ExecuteBatch( *_registry, commands, commandCount, results );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void Interpreter::ExecuteBatch( const std::string* commands, unsigned long commandCount, BatchResults& results )
+  {
+    _ExecuteBatch( *_registry, commands, commandCount, results );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void Interpreter::ExecuteBatch( std::string_view commandLines, BatchResults& results )
+  {
+    _ExecuteLines( *_registry, commandLines, results );
+  }
+
+  //=================================================================================================
+
+  namespace
+  {
+    const char _bytecodeMagic[4] = { 'I', 'P', 'B', 'C' };
+    const unsigned int _bytecodeVersion = 2;
+
+    // written as is, so that bytecode compiled on a machine of the other byte order is rejected
+    const unsigned int _bytecodeByteOrder = 0x01020304;
+
+    // Bytecode is a _BytecodeHeader, then symbolCount _BytecodeSymbols, commandCount
+    // _BytecodeCommands and argCount _BytecodeArgs, then the pool of stringsSize bytes that symbols
+    // and args point into. Every part is 8-byte aligned within the file.
+    struct _BytecodeHeader
+    {
+      char magic[4];
+      unsigned int version;
+      unsigned int byteOrder;
+      unsigned int symbolCount;
+      unsigned int commandCount;
+      unsigned int argCount;
+      unsigned long long stringsSize;
+    };
+
+    struct _BytecodeSymbol
+    {
+      unsigned int offset;
+      unsigned int size;
+    };
+
+    struct _BytecodeCommand
+    {
+      unsigned int objectSymbol;
+      unsigned int methodSymbol;
+      unsigned int firstArg;
+      unsigned int argCount;
+    };
+
+    // a param's text in the pool, as Execute() converts it: unescaped if quoted, as written if not
+    struct _BytecodeArg
+    {
+      unsigned int offset;
+      unsigned int size;
+    };
+
+    static_assert( sizeof( _BytecodeHeader ) == 32 && sizeof( _BytecodeSymbol ) == 8 &&
+                   sizeof( _BytecodeCommand ) == 16 && sizeof( _BytecodeArg ) == 8, "bytecode layout must not be padded" );
+
+    template< class Type >
+    void _AppendRaw( const std::vector< Type >& items, std::string& bytecode )
+    {
+      bytecode.append( ( const char* ) items.data(), items.size() * sizeof( Type ) );
+    }
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool CompileBytecode( std::string_view commandLines, std::string& bytecode, std::string& error )
+  {
+    _ArenaScope arena;
+    std::unordered_map< std::string_view, unsigned int > symbolIds;
+    std::vector< _BytecodeSymbol > symbols;
+    std::vector< _BytecodeCommand > commands;
+    std::vector< _BytecodeArg > args;
+    std::string strings;
+    unsigned long line = 0;
+
+    // returns the offset of text in the pool
+    auto addString = [&]( std::string_view text )
+    {
+      unsigned long long offset = strings.size();
+      strings.append( text );
+      return offset;
+    };
+
+    auto addSymbol = [&]( std::string_view name )
+    {
+      std::pair< std::unordered_map< std::string_view, unsigned int >::iterator, bool > symbol =
+          symbolIds.insert( std::make_pair( name, ( unsigned int ) symbols.size() ) );
+
+      if( symbol.second )
+      {
+        _BytecodeSymbol added = { ( unsigned int ) addString( name ), ( unsigned int ) name.size() };
+        symbols.push_back( added );
+      }
+
+      return symbol.first->second;
+    };
+
+    while( !commandLines.empty() )
+    {
+      std::size_t lineEnd = commandLines.find( '\n' );
+      std::string_view command = commandLines.substr( 0, lineEnd );
+
+      commandLines.remove_prefix( lineEnd == std::string_view::npos ? commandLines.size() : lineEnd + 1 );
+      line++;
+
+      if( !command.empty() && command.back() == '\r' )
+      {
+        command.remove_suffix( 1 );
+      }
+
+      if( command.find_first_not_of( " \t" ) == std::string_view::npos )
+      {
+        continue;
+      }
+
+      std::string_view objectName;
+      std::string_view methodName;
+      std::string_view params;
+
+      if( !_SplitCommand( command, objectName, methodName, params ) )
+      {
+        error = "Error: line " + std::to_string( line ) + ": not a command";
+        return false;
+      }
+
+      _Broadcast broadcast;
+      std::string broadcastError;
+
+      if( params.find( '(' ) != std::string_view::npos && broadcast.Parse( params, broadcastError ) && broadcast.IsBroadcast() )
+      {
+        error = "Error: line " + std::to_string( line ) + ": broadcasts cannot be compiled";
+        return false;
+      }
+
+      _ParamList paramList( params );
+      unsigned long argCount = paramList.IsBlank() ? 0 : paramList.Size();
+      _BytecodeCommand compiled = { addSymbol( objectName ), addSymbol( methodName ), ( unsigned int ) args.size(), ( unsigned int ) argCount };
+
+      // kept as text, so that a run converts each param for its method's type as Execute() does
+      for( unsigned long i = 0; i < argCount; ++i )
+      {
+        Value value = _ParseConstant( paramList, i );
+        _BytecodeArg arg = { ( unsigned int ) addString( value.AsString() ), ( unsigned int ) value.AsString().size() };
+        args.push_back( arg );
+      }
+
+      commands.push_back( compiled );
+
+      // offsets and counts are 32-bit
+      if( strings.size() > UINT_MAX || args.size() > UINT_MAX || symbols.size() > UINT_MAX )
+      {
+        error = "Error: line " + std::to_string( line ) + ": too many commands to compile";
+        return false;
+      }
+    }
+
+    _BytecodeHeader header = { { _bytecodeMagic[0], _bytecodeMagic[1], _bytecodeMagic[2], _bytecodeMagic[3] }, _bytecodeVersion,
+                               _bytecodeByteOrder, ( unsigned int ) symbols.size(), ( unsigned int ) commands.size(),
+                               ( unsigned int ) args.size(), strings.size() };
+
+    bytecode.clear();
+    bytecode.append( ( const char* ) &header, sizeof( header ) );
+    _AppendRaw( symbols, bytecode );
+    _AppendRaw( commands, bytecode );
+    _AppendRaw( args, bytecode );
+    bytecode += strings;
+    return true;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  class BytecodeProgram::_State
+  {
+  public:
+    _State()
+      : _registry( NULL ),
+        _epoch( 0 ),
+        _mapping( NULL ),
+        _mappingSize( 0 ) {}
+
+    ~_State()
+    {
+      _Release();
+    }
+
+    // Validates bytecode and resolves its commands. On success, runs read their args from bytecode
+    // from now on, so the memory it is in must be handed to Hold(); on failure, the program is left
+    // as it was.
+    bool Link( std::string_view bytecode, std::string& error, Interpreter& interpreter )
+    {
+      _BytecodeHeader header;
+
+      if( bytecode.size() < sizeof( header ) )
+      {
+        error = "Error: not Interpp bytecode";
+        return false;
+      }
+
+      // copied out, as a buffer in memory need not be aligned
+      std::memcpy( &header, bytecode.data(), sizeof( header ) );
+
+      if( std::memcmp( header.magic, _bytecodeMagic, sizeof( header.magic ) ) != 0 )
+      {
+        error = "Error: not Interpp bytecode";
+        return false;
+      }
+      else if( header.byteOrder != _bytecodeByteOrder )
+      {
+        error = "Error: bytecode was compiled for the other byte order";
+        return false;
+      }
+      else if( header.version != _bytecodeVersion )
+      {
+        error = "Error: bytecode version " + std::to_string( header.version ) + " is not supported";
+        return false;
+      }
+
+      // counts are 32-bit, so none of these sizes can overflow
+      unsigned long long symbolsStart = sizeof( header );
+      unsigned long long commandsStart = symbolsStart + header.symbolCount * ( unsigned long long ) sizeof( _BytecodeSymbol );
+      unsigned long long argsStart = commandsStart + header.commandCount * ( unsigned long long ) sizeof( _BytecodeCommand );
+      unsigned long long stringsStart = argsStart + header.argCount * ( unsigned long long ) sizeof( _BytecodeArg );
+
+      if( stringsStart > bytecode.size() || bytecode.size() - stringsStart != header.stringsSize )
+      {
+        error = "Error: bytecode is truncated or corrupt";
+        return false;
+      }
+
+      std::string_view strings = bytecode.substr( stringsStart );
+      std::vector< std::string_view > symbols( header.symbolCount );
+
+      for( unsigned long i = 0; i < header.symbolCount; ++i )
+      {
+        _BytecodeSymbol symbol;
+        std::memcpy( &symbol, bytecode.data() + symbolsStart + i * sizeof( symbol ), sizeof( symbol ) );
+
+        if( ( unsigned long long ) symbol.offset + symbol.size > strings.size() )
+        {
+          error = "Error: bytecode is truncated or corrupt";
+          return false;
+        }
+
+        symbols[i] = strings.substr( symbol.offset, symbol.size );
+      }
+
+      // checked here once, so that runs can decode args without checks
+      for( unsigned long i = 0; i < header.argCount; ++i )
+      {
+        _BytecodeArg arg;
+        std::memcpy( &arg, bytecode.data() + argsStart + i * sizeof( arg ), sizeof( arg ) );
+
+        if( ( unsigned long long ) arg.offset + arg.size > strings.size() )
+        {
+          error = "Error: bytecode is truncated or corrupt";
+          return false;
+        }
+      }
+
+      // each distinct object.Method is resolved once
+      std::unordered_map< unsigned long long, unsigned long > targetIds;
+      std::vector< _Target > targets;
+      std::vector< _Command > commands( header.commandCount );
+      unsigned long maxArgCount = 0;
+
+      for( unsigned long i = 0; i < header.commandCount; ++i )
+      {
+        _BytecodeCommand command;
+        std::memcpy( &command, bytecode.data() + commandsStart + i * sizeof( command ), sizeof( command ) );
+
+        if( command.objectSymbol >= header.symbolCount || command.methodSymbol >= header.symbolCount ||
+            ( unsigned long long ) command.firstArg + command.argCount > header.argCount )
+        {
+          error = "Error: bytecode is truncated or corrupt";
+          return false;
+        }
+
+        unsigned long long key = ( ( unsigned long long ) command.objectSymbol << 32 ) | command.methodSymbol;
+        std::pair< std::unordered_map< unsigned long long, unsigned long >::iterator, bool > target =
+            targetIds.insert( std::make_pair( key, targets.size() ) );
+
+        if( target.second )
+        {
+          _Target added = { symbols[command.objectSymbol], symbols[command.methodSymbol], NULL, NULL };
+          targets.push_back( added );
+        }
+
+        commands[i].target = target.first->second;
+        commands[i].firstArg = command.firstArg;
+        commands[i].argCount = command.argCount;
+        maxArgCount = std::max< unsigned long >( maxArgCount, command.argCount );
+      }
+
+      _commands.swap( commands );
+      _targets.swap( targets );
+      _registry = &interpreter._GetRegistry();
+      _argTable = bytecode.data() + argsStart;
+      _strings = strings;
+      _args.resize( maxArgCount );
+      _Resolve();
+      return true;
+    }
+
+    // keeps the memory the bytecode last linked is in, a mapping or a buffer (whose heap memory moves
+    // with it), releasing any held before; neither, for memory the caller keeps
+    void Hold( void* mapping, std::size_t mappingSize, std::string& buffer )
+    {
+      _Release();
+      _mapping = mapping;
+      _mappingSize = mappingSize;
+      _buffer.swap( buffer );
+    }
+
+    unsigned long CommandCount() const
+    {
+      return _commands.size();
+    }
+
+    void Run( BatchResults& results )
+    {
+      _ArenaScope arena;
+      std::string& text = results._Text();
+      Value result;
+
+      results.Clear();
+      results.Reserve( _commands.size(), 0 );
+
+      // an object linked may have been unregistered, or its name given to another, since
+      if( _registry != NULL && _epoch != _RegistryEpoch( *_registry ) )
+      {
+        _Resolve();
+      }
+
+      for( unsigned long i = 0; i < _commands.size(); ++i )
+      {
+        const _Command& command = _commands[i];
+        const _Target& target = _targets[command.target];
+
+        if( target.invoke != NULL )
+        {
+          // text is copied into each arg's own string, which keeps its capacity from one command to the
+          // next
+          for( unsigned long a = 0; a < command.argCount; ++a )
+          {
+            _BytecodeArg arg;
+            std::memcpy( &arg, _argTable + ( command.firstArg + a ) * sizeof( arg ), sizeof( arg ) );
+            _args[a]._Assign( _strings.substr( arg.offset, arg.size ) );
+          }
+
+          target.invoke( target.object, _args.data(), command.argCount, result );
+          result.AppendTo( text );
+        }
+        else
+        {
+          text += target.object == NULL ? "Error: object not found" : "Error: method not found";
+        }
+
+        results._EndResult();
+      }
+    }
+
+  private:
+    // a distinct object.Method, named by views into the bytecode
+    struct _Target
+    {
+      std::string_view objectName;
+      std::string_view methodName;
+      void* object;
+      _interppInvoke invoke;
+    };
+
+    struct _Command
+    {
+      unsigned long target;
+      unsigned long firstArg;
+      unsigned long argCount;
+    };
+
+    // looks every target up in the registry, as it is now
+    void _Resolve()
+    {
+      _epoch = _RegistryEpoch( *_registry );
+
+      for( unsigned long i = 0; i < _targets.size(); ++i )
+      {
+        _Target& target = _targets[i];
+        target.object = NULL;
+        target.invoke = _InterppRegistry::GetMethod( target.objectName, target.methodName, &target.object, *_registry ).invoke;
+      }
+    }
+
+    void _Release()
+    {
+#if !defined( _WIN32 )
+      if( _mapping != NULL )
+      {
+        munmap( _mapping, _mappingSize );
+      }
+#endif
+
+      _mapping = NULL;
+      _mappingSize = 0;
+      std::string().swap( _buffer );
+    }
+
+    std::vector< _Command > _commands;
+    std::vector< _Target > _targets;
+    _Registry* _registry;
+    unsigned long long _epoch;
+    const char* _argTable;
+    std::string_view _strings;
+    std::vector< Value > _args;
+
+    void* _mapping;
+    std::size_t _mappingSize;
+    std::string _buffer;
+  };
+
+  //-------------------------------------------------------------------------------------------------
+
+  BytecodeProgram::BytecodeProgram()
+    : _state( new _State() ) {}
+
+  //-------------------------------------------------------------------------------------------------
+
+  BytecodeProgram::~BytecodeProgram()
+  {
+    delete _state;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool BytecodeProgram::Load( const char* path, std::string& error, Interpreter& interpreter )
+  {
+#if defined( _WIN32 )
+    int fd = _open( path, _O_RDONLY | _O_BINARY );
+#else
+    int fd = open( path, O_RDONLY );
+#endif
+
+    if( fd < 0 )
+    {
+      error = "Error: could not open " + std::string( path );
+      return false;
+    }
+
+    bool loaded = false;
+    bool read = true;
+
+#if !defined( _WIN32 )
+    struct stat status;
+    void* mapping = MAP_FAILED;
+
+    if( fstat( fd, &status ) == 0 && S_ISREG( status.st_mode ) && status.st_size > 0 )
+    {
+      mapping = mmap( NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    }
+
+    // the file stays mapped for as long as the program runs it, so it must not be truncated
+    if( mapping != MAP_FAILED )
+    {
+      std::string noBuffer;
+      loaded = _state->Link( std::string_view( ( const char* ) mapping, status.st_size ), error, interpreter );
+
+      if( loaded )
+      {
+        _state->Hold( mapping, status.st_size, noBuffer );
+      }
+      else
+      {
+        munmap( mapping, status.st_size );
+      }
+
+      read = false;
+    }
+#endif
+
+    // empty files, pipes and devices are read instead
+    if( read )
+    {
+      std::string bytecode;
+      char buffer[65536];
+      long count;
+
+      while( ( count = _ReadFd( fd, buffer, sizeof( buffer ) ) ) > 0 )
+      {
+        bytecode.append( buffer, count );
+      }
+
+      if( count < 0 )
+      {
+        error = "Error: could not read " + std::string( path );
+      }
+      else if( _state->Link( bytecode, error, interpreter ) )
+      {
+        _state->Hold( NULL, 0, bytecode );
+        loaded = true;
+      }
+    }
+
+#if defined( _WIN32 )
+    _close( fd );
+#else
+    close( fd );
+#endif
+    return loaded;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  bool BytecodeProgram::Load( std::string_view bytecode, std::string& error, Interpreter& interpreter )
+  {
+    std::string noBuffer;
+
+    if( !_state->Link( bytecode, error, interpreter ) )
+    {
+      return false;
+    }
+
+    _state->Hold( NULL, 0, noBuffer );
+    return true;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned long BytecodeProgram::CommandCount() const
+  {
+    return _state->CommandCount();
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  void BytecodeProgram::Run( BatchResults& results )
+  {
+    _state->Run( results );
+  }
+
+  //=================================================================================================
+
+  void CallSite::_Rebind()
+  {
+    // read first, so that a registration published during the lookup is caught by the next call
+    _epoch = _RegistryEpoch( *_registry );
+
+    unsigned int typeId = 0;
+    void* object = _InterppRegistry::GetObject( _objectName, typeId, *_registry );
+
+    if( object == NULL )
+    {
+      _method = TypedMethod( "Error: object not found" );
+      _stats.misses++;
+      return;
+    }
+
+    for( unsigned int i = 0; i < _usedEntries; ++i )
+    {
+      if( _entries[i].object == object && _entries[i].typeId == typeId )
+      {
+        _method = _entries[i].method;
+        _stats.hits++;
+        return;
+      }
+    }
+
+    void* target = object;
+    _method = _ResolvedMethod( target, _InterppRegistry::FindMethod( typeId, _methodName, target ) );
+    _stats.misses++;
+
+    if( !_method.IsValid() )
+    {
+      return;
+    }
+
+    // the oldest entry makes way once the site has seen more objects than it keeps
+    _Entry& entry = _entries[_nextEntry];
+    entry.object = object;
+    entry.typeId = typeId;
+    entry.method = _method;
+
+    _nextEntry = ( _nextEntry + 1 ) % _size;
+    _usedEntries = _usedEntries < _size ? _usedEntries + 1 : _size;
+  }
+
+  //=================================================================================================
+
+  unsigned int _SymbolTable::Find( std::string_view name ) const
+  {
+    if( _slots.empty() )
+    {
+      return 0;
+    }
+
+    return _slots[ _Probe( name, _Hash( name ) ) ].id;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned int _SymbolTable::Intern( const std::string& name, std::deque< std::string >& nameStore )
+  {
+    return Intern( name, _Hash( name ), nameStore );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned int _SymbolTable::Intern( std::string_view name, unsigned long long hash, std::deque< std::string >& nameStore )
+  {
+    // keep the load factor at or below 1/2
+    if( ( _names.size() + 1 ) * 2 > _slots.size() )
+    {
+      std::vector< _Slot > oldSlots( _slots.empty() ? 16 : _slots.size() * 2 );
+      oldSlots.swap( _slots );
+
+      unsigned long mask = _slots.size() - 1;
+
+      for( unsigned long i = 0; i < oldSlots.size(); ++i )
+      {
+        if( oldSlots[i].id != 0 )
+        {
+          unsigned long j = ( unsigned long ) oldSlots[i].hash & mask;
+
+          while( _slots[j].id != 0 )
+          {
+            j = ( j + 1 ) & mask;
+          }
+
+          _slots[j] = oldSlots[i];
+        }
+      }
+    }
+
+    _Slot& slot = _slots[ _Probe( name, hash ) ];
+
+    if( slot.id == 0 )
+    {
+      nameStore.push_back( std::string( name ) );
+      _names.push_back( &nameStore.back() );
+      slot.hash = hash;
+      slot.id = _names.size();
+    }
+
+    return slot.id;
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned long long _SymbolTable::_Hash( std::string_view name )
+  {
+    return _HashName( name );
+  }
+
+  //-------------------------------------------------------------------------------------------------
+
+  unsigned long _SymbolTable::_Probe( std::string_view name, unsigned long long hash ) const
+  {
+    unsigned long mask = _slots.size() - 1;
+    unsigned long i = ( unsigned long ) hash & mask;
+
+    while( _slots[i].id != 0 &&
+           ( _slots[i].hash != hash || *_names[_slots[i].id - 1] != name ) )
+    {
+      i = ( i + 1 ) & mask;
+    }
 
-  std::map< std::string, _interppMethod > _InterppRegistry::_interppMethods;
-  std::map< std::string, _interppMethod >::const_iterator _InterppRegistry::_interppMethodsIt;
+    return i;
+  }
 }
 
 //=================================================================================================